@@ -13,6 +13,7 @@
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
 
 #include "FWCore/Utilities/interface/InputTag.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
 
 #include "DataFormats/PatCandidates/interface/Muon.h"
 #include "DataFormats/PatCandidates/interface/Electron.h"
@@ -38,6 +39,7 @@ public:
 
   // Operations
   virtual bool filter(edm::Event &, const edm::EventSetup&);
+  virtual void endJob();
 
   bool checkMuons(edm::Event &event, const edm::EventSetup&eSetup);
   bool checkElectrons(edm::Event &event, const edm::EventSetup&eSetup);
@@ -56,6 +58,13 @@ private:
   int minNum_;
   int filter_;
 
+  // events seen and rejected at each stage: too few candidates (before reading
+  // the vertices), no good vertex, too few candidates passing the cuts
+  unsigned long nEvents_;
+  unsigned long nRejectedMultiplicity_;
+  unsigned long nRejectedVertex_;
+  unsigned long nRejectedCuts_;
+
 };
 
 
@@ -65,7 +74,11 @@ ImpactParameterCuts::ImpactParameterCuts(const edm::ParameterSet& pset)
   , theDxyCut(pset.getParameter<double>("dXYcut"))
   , theZCut(pset.getParameter<double>("dZcut"))
   , minNum_(pset.getParameter<int>("MinNum"))
-  , filter_(pset.getParameter<bool>("filter")){
+  , filter_(pset.getParameter<bool>("filter"))
+  , nEvents_(0)
+  , nRejectedMultiplicity_(0)
+  , nRejectedVertex_(0)
+  , nRejectedCuts_(0){
 
   std::string type = pset.getParameter<std::string>("TypeOfInput");
   if(type == "muon"){
@@ -83,25 +96,24 @@ bool ImpactParameterCuts::checkMuons(edm::Event &event, const edm::EventSetup&eS
   edm::Handle<std::vector<reco::Muon> > muons;
   event.getByLabel(theInputLabel, muons);
 
+  // fast path: the event cannot have enough muons, whatever the vertex
+  if (filter_ && int(muons->size()) < minNum_) { ++nRejectedMultiplicity_; return false; }
+
   edm::Handle<std::vector<reco::Vertex> > vertices;
   event.getByLabel(theVtxLabel, vertices);
   
-  if (vertices->empty() || vertices->front().isFake()) return false;
+  if (vertices->empty() || vertices->front().isFake()) { ++nRejectedVertex_; return false; }
+  const reco::Vertex::Point& pv = vertices->front().position();
 
-  reco::MuonRef::key_type muIndex = 0;
-  
   std::auto_ptr<std::vector<reco::Muon> >    output(new std::vector<reco::Muon>());
-  std::auto_ptr<std::vector<reco::MuonRef> > outputRef(new std::vector<reco::MuonRef>());
 
   int count = 0;
-  for(std::vector<reco::Muon>::const_iterator muon = muons->begin(); muon != muons->end(); ++muon, ++muIndex){
+  for(std::vector<reco::Muon>::const_iterator muon = muons->begin(); muon != muons->end(); ++muon){
     if (muon->innerTrack().isNonnull()){
-      if(fabs(muon->innerTrack()->dxy(vertices->front().position())) >= theDxyCut) continue;
-      if(fabs(muon->innerTrack()->dz(vertices->front().position())) >= theZCut) continue;
+      if(fabs(muon->innerTrack()->dxy(pv)) >= theDxyCut) continue;
+      if(fabs(muon->innerTrack()->dz(pv)) >= theZCut) continue;
     }
     output->push_back(reco::Muon(*muon));
-
-    outputRef->push_back(reco::MuonRef(muons, muIndex));
     
     ++count;
 
@@ -109,6 +121,7 @@ bool ImpactParameterCuts::checkMuons(edm::Event &event, const edm::EventSetup&eS
 
   event.put(output);
   //event.put(outputRef);
+  if (filter_ && count < minNum_) ++nRejectedCuts_;
   return filter_ ? count >= minNum_ : true;
 
 
@@ -120,17 +133,21 @@ bool ImpactParameterCuts::checkElectrons(edm::Event &event, const edm::EventSetu
   edm::Handle<std::vector<reco::Electron> > electrons;
   event.getByLabel(theInputLabel, electrons);
 
+  // fast path: the event cannot have enough electrons, whatever the vertex
+  if (filter_ && int(electrons->size()) < minNum_) { ++nRejectedMultiplicity_; return false; }
+
   edm::Handle<std::vector<reco::Vertex> > vertices;
   event.getByLabel(theVtxLabel, vertices);
   
-  if (vertices->empty() || vertices->front().isFake()) return false;
+  if (vertices->empty() || vertices->front().isFake()) { ++nRejectedVertex_; return false; }
+  const reco::Vertex::Point& pv = vertices->front().position();
 
   std::auto_ptr<std::vector<reco::Electron> >    output(new std::vector<reco::Electron>());
 
   int count = 0;
   for(std::vector<reco::Electron>::const_iterator electron = electrons->begin(); electron != electrons->end(); ++electron){
-    if(fabs(electron->gsfTrack()->dxy(vertices->front().position()))       >= theDxyCut) continue;
-    if(fabs(electron->gsfTrack()->vz() - vertices->front().position().z()) >= theZCut) continue;
+    if(fabs(electron->gsfTrack()->dxy(pv))       >= theDxyCut) continue;
+    if(fabs(electron->gsfTrack()->vz() - pv.z()) >= theZCut) continue;
     
     output->push_back(reco::Electron(*electron));
 
@@ -140,6 +157,7 @@ bool ImpactParameterCuts::checkElectrons(edm::Event &event, const edm::EventSetu
 
   event.put(output);
   //event.put(outputRef);
+  if (filter_ && count < minNum_) ++nRejectedCuts_;
   return filter_ ? count >= minNum_ : true;
 
 
@@ -148,6 +166,7 @@ bool ImpactParameterCuts::checkElectrons(edm::Event &event, const edm::EventSetu
 
 bool ImpactParameterCuts::filter(edm::Event &event, const edm::EventSetup&eSetup){
  
+  ++nEvents_;
   if(type_ == ImpactParameterCuts::Muon)
     return checkMuons(event, eSetup);
   else if(type_ == ImpactParameterCuts::Electron)
@@ -158,6 +177,14 @@ bool ImpactParameterCuts::filter(edm::Event &event, const edm::EventSetup&eSetup
 
 }
 
+void ImpactParameterCuts::endJob(){
+
+  edm::LogVerbatim("ImpactParameterCuts") << "ImpactParameterCuts: " << nEvents_ << " events, rejected"
+					  << " by multiplicity (fast path): " << nRejectedMultiplicity_
+					  << ", by vertex: " << nRejectedVertex_
+					  << ", by IP cuts: " << nRejectedCuts_;
+}
+
 #include "FWCore/Framework/interface/MakerMacros.h"
 
 DEFINE_FWK_MODULE(ImpactParameterCuts);
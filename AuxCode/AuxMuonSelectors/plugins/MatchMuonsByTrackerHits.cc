@@ -1,14 +1,24 @@
 // -*- C++ -*-
 //
 // Package:    MatchMuonsByTrackerHits
-// Class:      MatchMuonsByTrackerHits
-// 
-/**\class MatchMuonsByTrackerHits MatchMuonsByTrackerHits.cc AuuCode/MatchMuonsByTrackerHits/src/MatchMuonsByTrackerHits.cc
+// Class:      MatchByTrackerHits
+//
+/**\class MatchByTrackerHits MatchMuonsByTrackerHits.cc AuuCode/MatchMuonsByTrackerHits/src/MatchMuonsByTrackerHits.cc
 
- Description: [one line class summary]
+ Description: selects the candidates of the second collection sharing tracker hits with the first one
 
  Implementation:
-     [Notes on implementation]
+     Templated over the candidate type: MatchMuonsByTrackerHits (reco::Muon, inner track)
+     and MatchTracksByTrackerHits (reco::Track).
+     When the two input tags are the same, the collection is cleaned from its own
+     duplicates (only the pairs i<j are compared) and the surviving candidates are stored.
+     In this mode a candidate already rejected is not compared any more, as in the
+     track list merger.
+     Only the pairs of candidates with hits on a common module are compared. With
+     NumberOfThreads>1 the hit overlaps are evaluated in parallel (one task per candidate
+     of the first collection) on a TBB scheduler limited to that many threads; the
+     duplicates are then arbitrated serially in the (i,j) order, so that the result does
+     not depend on the number of threads.
 */
 //
 // Original Author:  Ernesto Migliore,13 2-017,+41227672059,
@@ -21,6 +31,13 @@
 // system include files
 #include <memory>
 #include <iostream>
+#include <algorithm>
+#include <utility>
+
+#include "tbb/parallel_for.h"
+#include "tbb/blocked_range.h"
+#include "tbb/enumerable_thread_specific.h"
+#include "tbb/task_scheduler_init.h"
 
 // user include files
 #include "FWCore/Utilities/interface/InputTag.h"
@@ -46,6 +63,7 @@
 #include "DataFormats/TrackReco/interface/TrackExtra.h"
 #include "DataFormats/TrackingRecHit/interface/TrackingRecHit.h"
 
+#include "DataFormats/SiStripDetId/interface/StripSubdetector.h"
 #include "DataFormats/TrackerRecHit2D/interface/SiStripMatchedRecHit2DCollection.h"
 #include "DataFormats/TrackerRecHit2D/interface/SiStripRecHit2DCollection.h"
 #include "DataFormats/TrackerRecHit2D/interface/SiStripRecHit1DCollection.h"
@@ -56,30 +74,58 @@
 #include "Geometry/TrackerGeometryBuilder/interface/TrackerGeometry.h"
 #include "Geometry/Records/interface/TrackerDigiGeometryRecord.h"
 
+//
+// traits giving access to the tracker track of the candidates
+//
+
+template <typename T> struct TrackerHitsTraits;
+
+template <> struct TrackerHitsTraits<reco::Muon> {
+  static std::string srcName() { return "muonSrc"; }
+  static const reco::Track* track(const reco::Muon& muon) {
+    return muon.isAValidMuonTrack(reco::Muon::InnerTrack) ? muon.innerTrack().get() : 0;
+  }
+};
+
+template <> struct TrackerHitsTraits<reco::Track> {
+  static std::string srcName() { return "trackSrc"; }
+  static const reco::Track* track(const reco::Track& track) { return &track; }
+};
+
 //
 // class declaration
 //
 
-class MatchMuonsByTrackerHits : public edm::EDProducer {
+template <typename T>
+class MatchByTrackerHits : public edm::EDProducer {
 public:
-  explicit MatchMuonsByTrackerHits(const edm::ParameterSet&);
-  ~MatchMuonsByTrackerHits();
-  
+  explicit MatchByTrackerHits(const edm::ParameterSet&);
+  ~MatchByTrackerHits();
+
   static void fillDescriptions(edm::ConfigurationDescriptions& descriptions);
-  
+
 private:
+  typedef std::vector<const TrackingRecHit*> HitVector;
+
   virtual void beginJob() ;
   virtual void produce(edm::Event&, const edm::EventSetup&);
   virtual void endJob() ;
-  
+
   virtual void beginRun(edm::Run&, edm::EventSetup const&);
   virtual void endRun(edm::Run&, edm::EventSetup const&);
   virtual void beginLuminosityBlock(edm::LuminosityBlock&, edm::EventSetup const&);
   virtual void endLuminosityBlock(edm::LuminosityBlock&, edm::EventSetup const&);
-  
+
+  // module used to pre-select the pairs (strip mono/stereo hits are mapped to the glued module)
+  static unsigned int moduleKey(const TrackingRecHit* hit);
+  // number of overlapping hits of two candidates
+  int overlaps(const HitVector& iHits, const HitVector& jHits, int& firstoverlap) const;
+  // fills duplicates_[i] with the candidates of the second collection duplicating the i-th of the first one
+  void findDuplicates(unsigned int i, std::vector<unsigned int>& candidates);
+
   // ----------member data ---------------------------
-  edm::InputTag muonCollectionTag1_;
-  edm::InputTag muonCollectionTag2_;
+  edm::InputTag collectionTag1_;
+  edm::InputTag collectionTag2_;
 
   double epsilon_;
   bool use_sharesInput_;
@@ -87,6 +133,20 @@ private:
   double foundHitBonus_;
   double lostHitPenalty_;
   bool allowFirstHitShare_;
+  bool sameCollection_;
+
+  // the jobs get one batch slot: the overlaps are evaluated serially unless asked otherwise
+  int nThreads_;
+  std::auto_ptr<tbb::task_scheduler_init> scheduler_;
+
+  // scratch buffers reused across events: they are cleared, not freed, at each
+  // event so that at steady state produce() does not allocate besides the output
+  std::vector<const reco::Track*> tk1_, tk2_;
+  std::vector<HitVector> rh1_, rh2_;
+  std::vector<int> selected1_, selected2_;
+  std::vector<std::pair<unsigned int,unsigned int> > moduleIndex_;
+  std::vector<std::vector<unsigned int> > duplicates_;
+  tbb::enumerable_thread_specific<std::vector<unsigned int> > candidates_;
   //
 
 };
@@ -94,7 +154,14 @@ private:
 //
 // constants, enums and typedefs
 //
-
+namespace {
+  // empties the first n inner vectors keeping their capacity
+  template <typename V>
+  void resetScratch(std::vector<V>& v, unsigned int n) {
+    if ( v.size()<n ) v.resize(n);
+    for ( unsigned int i=0; i<n; ++i ) v[i].clear();
+  }
+}
 
 //
 // static data member definitions
@@ -103,23 +170,29 @@ private:
 //
 // constructors and destructor
 //
-MatchMuonsByTrackerHits::MatchMuonsByTrackerHits(const edm::ParameterSet& iConfig):
-muonCollectionTag1_(iConfig.getParameter<edm::InputTag>("muonSrc1")),
-muonCollectionTag2_(iConfig.getParameter<edm::InputTag>("muonSrc2")),
+template <typename T>
+MatchByTrackerHits<T>::MatchByTrackerHits(const edm::ParameterSet& iConfig):
+collectionTag1_(iConfig.getParameter<edm::InputTag>(TrackerHitsTraits<T>::srcName()+"1")),
+collectionTag2_(iConfig.getParameter<edm::InputTag>(TrackerHitsTraits<T>::srcName()+"2")),
 epsilon_(iConfig.getParameter<double>("Epsilon")),
 shareFrac_(iConfig.getParameter<double>("ShareFrac")),
 foundHitBonus_(iConfig.getParameter<double>("FoundHitBonus")),
 lostHitPenalty_(iConfig.getParameter<double>("LostHitPenalty")),
-allowFirstHitShare_(iConfig.getParameter<bool>("allowFirstHitShare"))
+allowFirstHitShare_(iConfig.getParameter<bool>("allowFirstHitShare")),
+nThreads_(iConfig.getUntrackedParameter<int>("NumberOfThreads",1))
 {
-  produces<std::vector<reco::Muon> >();  
+  produces<std::vector<T> >();
   use_sharesInput_ = true;
   if ( epsilon_ > 0.0 ) use_sharesInput_ = false;
+  sameCollection_ = ( collectionTag1_ == collectionTag2_ );
+  // otherwise TBB would start one thread per core of the node
+  if ( nThreads_>1 ) scheduler_.reset(new tbb::task_scheduler_init(nThreads_));
 
 }
 
 
-MatchMuonsByTrackerHits::~MatchMuonsByTrackerHits()
+template <typename T>
+MatchByTrackerHits<T>::~MatchByTrackerHits()
 {
 }
 
@@ -128,208 +201,239 @@ MatchMuonsByTrackerHits::~MatchMuonsByTrackerHits()
 // member functions
 //
 
+template <typename T>
+unsigned int
+MatchByTrackerHits<T>::moduleKey(const TrackingRecHit* hit)
+{
+  DetId id = hit->geographicalId();
+  if ( id.det()==DetId::Tracker && id.subdetId()>=StripSubdetector::TIB ) return id.rawId() & ~3u;
+  return id.rawId();
+}
+
+template <typename T>
+int
+MatchByTrackerHits<T>::overlaps(const HitVector& iHits, const HitVector& jHits, int& firstoverlap) const
+{
+  int noverlap=0;
+  firstoverlap=0;
+  unsigned nh1 = iHits.size();
+  unsigned nh2 = jHits.size();
+  for ( unsigned ih=0; ih<nh1; ++ih ) {
+    const TrackingRecHit* it = iHits[ih];
+    if (it->isValid()){
+      for ( unsigned jh=0; jh<nh2; ++jh ) {
+	const TrackingRecHit* jt = jHits[jh];
+	if (jt->isValid()){
+	  if (!use_sharesInput_){
+	    float delta = fabs ( it->localPosition().x()-jt->localPosition().x() );
+	    if ((it->geographicalId()==jt->geographicalId())&&(delta<epsilon_)) {
+	      noverlap++;
+	      if ( allowFirstHitShare_ && ( ih == 0 ) && ( jh == 0 ) ) firstoverlap=1;
+	    }
+	  }else{
+	    if ( it->sharesInput(jt,TrackingRecHit::some) ) {
+	      noverlap++;
+	      if ( allowFirstHitShare_ && ( ih == 0 ) && ( jh == 0 ) ) firstoverlap=1;
+	    }
+	  }
+	}
+      }
+    }
+  }
+  return noverlap;
+}
+
+template <typename T>
+void
+MatchByTrackerHits<T>::findDuplicates(unsigned int i, std::vector<unsigned int>& candidates)
+{
+  const HitVector& iHits = rh1_[i];
+  if (iHits.empty()) return;
+  // candidates of the second collection with a valid hit on one of the modules of the i-th
+  candidates.clear();
+  for (unsigned int ih=0; ih<iHits.size(); ++ih){
+    if (!iHits[ih]->isValid()) continue;
+    std::vector<std::pair<unsigned int,unsigned int> >::const_iterator first =
+      std::lower_bound(moduleIndex_.begin(),moduleIndex_.end(),std::make_pair(moduleKey(iHits[ih]),0u));
+    for (; first!=moduleIndex_.end() && first->first==moduleKey(iHits[ih]); ++first) candidates.push_back(first->second);
+  }
+  std::sort(candidates.begin(),candidates.end());
+  candidates.erase(std::unique(candidates.begin(),candidates.end()),candidates.end());
+
+  for (unsigned int k=0; k<candidates.size(); ++k){
+    unsigned int j = candidates[k];
+    if ( sameCollection_ && j<=i ) continue;
+    int firstoverlap=0;
+    int noverlap = overlaps(iHits,rh2_[j],firstoverlap);
+    int nhit1 = tk1_[i]->numberOfValidHits();
+    int nhit2 = tk2_[j]->numberOfValidHits();
+    if ( (noverlap-firstoverlap) > (std::min(nhit1,nhit2)-firstoverlap)*shareFrac_ ) duplicates_[i].push_back(j);
+  }
+}
+
 // ------------ method called to produce the data  ------------
+template <typename T>
 void
-MatchMuonsByTrackerHits::produce(edm::Event& iEvent, const edm::EventSetup& iSetup)
+MatchByTrackerHits<T>::produce(edm::Event& iEvent, const edm::EventSetup& iSetup)
 {
    using namespace edm;
- 
-   edm::Handle<std::vector<reco::Muon> > mC1;
-   iEvent.getByLabel(muonCollectionTag1_,mC1);
-
-   edm::Handle<std::vector<reco::Muon> > mC2;
-   iEvent.getByLabel(muonCollectionTag2_,mC2);
-
-   std::map<reco::MuonCollection::const_iterator, std::vector<const TrackingRecHit*> > rh1;
-   std::map<reco::MuonCollection::const_iterator, std::vector<const TrackingRecHit*> > rh2;
-
-   std::vector<int> selected1; for (unsigned int i=0; i<mC1->size(); ++i){selected1.push_back(1);}
-   std::vector<int> selected2; for (unsigned int i=0; i<mC2->size(); ++i){selected2.push_back(1);}
-
-   // fill a map of the rechit associated to the inner tracks of the muons in the first collection
-   int iMu1=0;
-   for(std::vector<reco::Muon>::const_iterator recomuon_it=mC1->begin(); recomuon_it!=mC1->end(); ++recomuon_it, ++iMu1){
-     if (recomuon_it->isAValidMuonTrack(reco::Muon::InnerTrack)){
-       const reco::Track & track = *(recomuon_it->innerTrack());
-       trackingRecHit_iterator itB = track.recHitsBegin();
-       trackingRecHit_iterator itE = track.recHitsEnd();
-       for (trackingRecHit_iterator it = itB;  it != itE; ++it) { 
-	 const TrackingRecHit* hit = &(**it);
-	 rh1[recomuon_it].push_back(hit);
-       }
-     } else {
-       rh1[recomuon_it].clear();
-     }
 
+   edm::Handle<std::vector<T> > mC1;
+   iEvent.getByLabel(collectionTag1_,mC1);
+
+   edm::Handle<std::vector<T> > mC2;
+   iEvent.getByLabel(collectionTag2_,mC2);
+
+   const unsigned int n1 = mC1->size();
+   const unsigned int n2 = mC2->size();
+
+   // tracker tracks and rechits of the candidates of the two collections
+   std::vector<const reco::Track*>& tk1 = tk1_;
+   std::vector<const reco::Track*>& tk2 = tk2_;
+   tk1.assign(n1,0);
+   tk2.assign(n2,0);
+   std::vector<HitVector>& rh1 = rh1_;
+   std::vector<HitVector>& rh2 = rh2_;
+   resetScratch(rh1,n1);
+   resetScratch(rh2,n2);
+   for (unsigned int i=0; i<n1; ++i){
+     tk1[i] = TrackerHitsTraits<T>::track((*mC1)[i]);
+     if (tk1[i]) for (trackingRecHit_iterator it = tk1[i]->recHitsBegin(); it != tk1[i]->recHitsEnd(); ++it) rh1[i].push_back(&(**it));
    }
-   // fill a map of the rechit associated to the inner tracks of the muons in the second collection
-   int iMu2=0;
-   for(std::vector<reco::Muon>::const_iterator recomuon_it=mC2->begin(); recomuon_it!=mC2->end(); ++recomuon_it, ++iMu2){
-     if (recomuon_it->isAValidMuonTrack(reco::Muon::InnerTrack)){
-       const reco::Track & track = *(recomuon_it->innerTrack());
-       trackingRecHit_iterator itB = track.recHitsBegin();
-       trackingRecHit_iterator itE = track.recHitsEnd();
-       for (trackingRecHit_iterator it = itB;  it != itE; ++it) { 
-	 const TrackingRecHit* hit = &(**it);
-	 rh2[recomuon_it].push_back(hit);
+   for (unsigned int j=0; j<n2; ++j){
+     tk2[j] = TrackerHitsTraits<T>::track((*mC2)[j]);
+     if (tk2[j]) for (trackingRecHit_iterator it = tk2[j]->recHitsBegin(); it != tk2[j]->recHitsEnd(); ++it) rh2[j].push_back(&(**it));
+   }
+
+   std::vector<int>& selected1 = selected1_;
+   std::vector<int>& selected2 = selected2_;
+   selected1.assign(n1,1);
+   selected2.assign(n2,1);
+   // when cleaning a collection from its own duplicates the two selections are the same
+   std::vector<int>& sel2 = sameCollection_ ? selected1 : selected2;
+
+   if ( (0<n1) && (0<n2) ){
+     // index of the modules crossed by the candidates of the second collection
+     std::vector<std::pair<unsigned int,unsigned int> >& moduleIndex = moduleIndex_;
+     moduleIndex.clear();
+     for (unsigned int j=0; j<n2; ++j){
+       for (unsigned int jh=0; jh<rh2[j].size(); ++jh){
+	 if (rh2[j][jh]->isValid()) moduleIndex.push_back(std::make_pair(moduleKey(rh2[j][jh]),j));
        }
+     }
+     std::sort(moduleIndex.begin(),moduleIndex.end());
+
+     // duplicates of each candidate of the first collection
+     std::vector<std::vector<unsigned int> >& duplicates = duplicates_;
+     resetScratch(duplicates,n1);
+     if ( nThreads_>1 ) {
+       tbb::parallel_for(tbb::blocked_range<unsigned int>(0,n1), [&](const tbb::blocked_range<unsigned int>& range) {
+	   std::vector<unsigned int>& candidates = candidates_.local();
+	   for (unsigned int i=range.begin(); i!=range.end(); ++i) findDuplicates(i,candidates);
+	 });
      } else {
-       rh2[recomuon_it].clear();
+       std::vector<unsigned int>& candidates = candidates_.local();
+       for (unsigned int i=0; i<n1; ++i) findDuplicates(i,candidates);
      }
-   }
 
-   
-   if ( (0<mC1->size()) && (0<mC2->size()) ){
-     int i=-1;
-     for (reco::MuonCollection::const_iterator muon1=mC1->begin(); muon1!=mC1->end(); ++muon1){
-       i++; 
-       std::vector<const TrackingRecHit*>& iHits = rh1[muon1]; 
-       unsigned nh1 = iHits.size();
-       if (nh1==0) {selected1[i]=1; continue;}
-       int j=-1;
-       for (reco::MuonCollection::const_iterator muon2=mC2->begin(); muon2!=mC2->end(); ++muon2){
-	 j++;
-	 std::vector<const TrackingRecHit*>& jHits = rh2[muon2]; 
-	 unsigned nh2 = jHits.size();
-	 if (nh2==0) {selected2[j]=1; continue;}
-	 int noverlap=0;
-	 int firstoverlap=0;
-	 for ( unsigned ih=0; ih<nh1; ++ih ) { 
-	   const TrackingRecHit* it = iHits[ih];
-	   if (it->isValid()){
-	     int jj=-1;
-	     for ( unsigned jh=0; jh<nh2; ++jh ) { 
-	       const TrackingRecHit* jt = jHits[jh];
-	       jj++;
-	       if (jt->isValid()){
-		 if (!use_sharesInput_){
-		   float delta = fabs ( it->localPosition().x()-jt->localPosition().x() ); 
-		   if ((it->geographicalId()==jt->geographicalId())&&(delta<epsilon_)) {
-		     noverlap++;
-		     if ( allowFirstHitShare_ && ( ih == 0 ) && ( jh == 0 ) ) firstoverlap=1;
-		   }
-		 }else{
-		   if ( it->sharesInput(jt,TrackingRecHit::some) ) {
-		     noverlap++;
-		     if ( allowFirstHitShare_ && ( ih == 0 ) && ( jh == 0 ) ) firstoverlap=1;
-		   }
-		 }
-	       }
-	     }
-	   }
+     // arbitration, in the same order as a serial loop over the pairs
+     for (unsigned int i=0; i<n1; ++i){
+       for (unsigned int k=0; k<duplicates[i].size(); ++k){
+	 unsigned int j = duplicates[i][k];
+	 // cleaning a collection: a candidate already rejected cannot be brought back by a later pair
+	 if ( sameCollection_ ) {
+	   if ( selected1[i]==0 ) break;
+	   if ( sel2[j]==0 ) continue;
 	 }
-	 //
-
-	 int newQualityMask =( muon1->innerTrack()->qualityMask() | muon2->innerTrack()->qualityMask() ); // take OR of trackQuality 
-	 int nhit1 = muon1->innerTrack()->numberOfValidHits();
-	 int nhit2 = muon2->innerTrack()->numberOfValidHits();
-	 if ( (noverlap-firstoverlap) > (std::min(nhit1,nhit2)-firstoverlap)*shareFrac_ ) {
-	   double score1 = foundHitBonus_*nhit1 - lostHitPenalty_*muon1->innerTrack()->numberOfLostHits() - muon1->innerTrack()->chi2();
-	   double score2 = foundHitBonus_*nhit2 - lostHitPenalty_*muon2->innerTrack()->numberOfLostHits() - muon2->innerTrack()->chi2();
-	   const double almostSame = 1.001;
-	   if ( score1 > almostSame * score2 ){
-	     selected2[j]=0; 
+	 const reco::Track* track1 = tk1[i];
+	 const reco::Track* track2 = tk2[j];
+	 int newQualityMask =( track1->qualityMask() | track2->qualityMask() ); // take OR of trackQuality
+	 int nhit1 = track1->numberOfValidHits();
+	 int nhit2 = track2->numberOfValidHits();
+	 double score1 = foundHitBonus_*nhit1 - lostHitPenalty_*track1->numberOfLostHits() - track1->chi2();
+	 double score2 = foundHitBonus_*nhit2 - lostHitPenalty_*track2->numberOfLostHits() - track2->chi2();
+	 const double almostSame = 1.001;
+	 if ( score1 > almostSame * score2 ){
+	   sel2[j]=0;
+	   selected1[i]=10+newQualityMask; // add 10 to avoid the case where mask = 1
+	 }else if ( score2 > almostSame * score1 ){
+	   selected1[i]=0;
+	   sel2[j]=10+newQualityMask;  // add 10 to avoid the case where mask = 1
+	 }else{
+	   if ( track1->algo() <= track2->algo()) {
+	     sel2[j]=0;
 	     selected1[i]=10+newQualityMask; // add 10 to avoid the case where mask = 1
-	   }else if ( score2 > almostSame * score1 ){
-	     selected1[i]=0; 
-	     selected2[j]=10+newQualityMask;  // add 10 to avoid the case where mask = 1
 	   }else{
-	     if ( muon1->innerTrack()->algo() <= muon2->innerTrack()->algo()) {
-	       selected2[j]=0;
-	       selected1[i]=10+newQualityMask; // add 10 to avoid the case where mask = 1
-	     }else{
-	       selected1[i]=0;
-	       selected2[j]=10+newQualityMask; // add 10 to avoid the case where mask = 1
-	     }
+	     selected1[i]=0;
+	     sel2[j]=10+newQualityMask; // add 10 to avoid the case where mask = 1
 	   }
-	 }//end got a duplicate
-       }//end track2 loop
+	 }
+       }//end duplicates loop
      }//end track loop
    }//end more than 1 track
-   
+
   //
-  //  output selected muons - if any
+  //  output selected candidates - if any
   //
-   // the output
-   std::vector<reco::Muon> matchedMuons;
-   //   std::vector<reco::Track> matchedMuonTracks;
-   //   std::vector<reco::TrackExtra> matchedMuonsTrackExtras;
-     
-
-   if ( 0<mC1->size()) {
-     int i=0;
-     for (reco::MuonCollection::const_iterator muon=mC1->begin(); muon!=mC1->end(); 
-	  ++muon, ++i){
-       // debug
-       if ( false ) std::cout<<"MU1 pT/sel " << muon->innerTrack()->pt() << " " <<
-	 muon->innerTrack()->innerDetId() << " " << 
-	 muon->innerTrack()->outerDetId() << " " << 
-	 selected1[i] << std::endl;
-     }
-   }
-   
-   if ( 0<mC2->size()) {
-     int i=0;
-     for (reco::MuonCollection::const_iterator muon=mC2->begin(); muon!=mC2->end(); 
-	  ++muon, ++i){
- // debug 
-      if ( false ) std::cout<<"MU2 pT/sel " << muon->innerTrack()->pt() << " " << 
-	 muon->innerTrack()->innerDetId() << " " << 
-	 muon->innerTrack()->outerDetId() << " " << 
-	 selected2[i] << std::endl;
-
-       //--------------------- TO BE CHECKED --------------------------//
-       if ( selected2[i]!=1 ) matchedMuons.push_back(*muon);
-       //--------------------------------------------------------------//
-
+   std::auto_ptr<std::vector<T> > matchedCollection( new std::vector<T>() );
+   for (unsigned int j=0; j<n2; ++j){
+     if ( sameCollection_ ) {
+       if ( selected1[j]!=0 ) matchedCollection->push_back((*mC2)[j]);
+       continue;
      }
+     //--------------------- TO BE CHECKED --------------------------//
+     if ( selected2[j]!=1 ) matchedCollection->push_back((*mC2)[j]);
+     //--------------------------------------------------------------//
    }
-
-   
-   // the output
-   std::auto_ptr<std::vector<reco::Muon> > matchedMuonCollection( new std::vector<reco::Muon> (matchedMuons) );
-   iEvent.put(matchedMuonCollection);
+   iEvent.put(matchedCollection);
 
 }
 
 // ------------ method called once each job just before starting event loop  ------------
-void 
-MatchMuonsByTrackerHits::beginJob()
+template <typename T>
+void
+MatchByTrackerHits<T>::beginJob()
 {
 }
 
 // ------------ method called once each job just after ending the event loop  ------------
-void 
-MatchMuonsByTrackerHits::endJob() {
+template <typename T>
+void
+MatchByTrackerHits<T>::endJob() {
 }
 
 // ------------ method called when starting to processes a run  ------------
-void 
-MatchMuonsByTrackerHits::beginRun(edm::Run&, edm::EventSetup const&)
+template <typename T>
+void
+MatchByTrackerHits<T>::beginRun(edm::Run&, edm::EventSetup const&)
 {
 }
 
 // ------------ method called when ending the processing of a run  ------------
-void 
-MatchMuonsByTrackerHits::endRun(edm::Run&, edm::EventSetup const&)
+template <typename T>
+void
+MatchByTrackerHits<T>::endRun(edm::Run&, edm::EventSetup const&)
 {
 }
 
 // ------------ method called when starting to processes a luminosity block  ------------
-void 
-MatchMuonsByTrackerHits::beginLuminosityBlock(edm::LuminosityBlock&, edm::EventSetup const&)
+template <typename T>
+void
+MatchByTrackerHits<T>::beginLuminosityBlock(edm::LuminosityBlock&, edm::EventSetup const&)
 {
 }
 
 // ------------ method called when ending the processing of a luminosity block  ------------
-void 
-MatchMuonsByTrackerHits::endLuminosityBlock(edm::LuminosityBlock&, edm::EventSetup const&)
+template <typename T>
+void
+MatchByTrackerHits<T>::endLuminosityBlock(edm::LuminosityBlock&, edm::EventSetup const&)
 {
 }
 
 // ------------ method fills 'descriptions' with the allowed parameters for the module  ------------
+template <typename T>
 void
-MatchMuonsByTrackerHits::fillDescriptions(edm::ConfigurationDescriptions& descriptions) {
+MatchByTrackerHits<T>::fillDescriptions(edm::ConfigurationDescriptions& descriptions) {
   //The following says we do not know what parameters are allowed so do no validation
   // Please change this to state exactly what you do use, even if it is no parameters
   edm::ParameterSetDescription desc;
@@ -337,5 +441,9 @@ MatchMuonsByTrackerHits::fillDescriptions(edm::ConfigurationDescriptions& descri
   descriptions.addDefault(desc);
 }
 
+typedef MatchByTrackerHits<reco::Muon>  MatchMuonsByTrackerHits;
+typedef MatchByTrackerHits<reco::Track> MatchTracksByTrackerHits;
+
 //define this as a plug-in
 DEFINE_FWK_MODULE(MatchMuonsByTrackerHits);
+DEFINE_FWK_MODULE(MatchTracksByTrackerHits);
@@ -32,6 +32,7 @@
 #include "FWCore/Framework/interface/MakerMacros.h"
 
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
 
 #include "DataFormats/VertexReco/interface/VertexFwd.h"
 #include "DataFormats/VertexReco/interface/Vertex.h"
@@ -71,6 +72,11 @@ private:
   edm::InputTag vertexCollectionTag_;
   bool isPF_;
 
+  // events seen and events skipped before reading the vertices (no global muon, no vertex)
+  unsigned long nEvents_;
+  unsigned long nNoCandidate_;
+  unsigned long nNoVertex_;
+
 };
 
 //
@@ -88,7 +94,10 @@ private:
 TightMuonProducer::TightMuonProducer(const edm::ParameterSet& iConfig):
 muonCollectionTag_(iConfig.getParameter<edm::InputTag>("muonSrc")),
 vertexCollectionTag_(iConfig.getParameter<edm::InputTag>("vertexSrc")),
-isPF_(iConfig.getUntrackedParameter<bool>("isPF"))
+isPF_(iConfig.getUntrackedParameter<bool>("isPF")),
+nEvents_(0),
+nNoCandidate_(0),
+nNoVertex_(0)
 {
   //now do what ever other initialization is needed
   produces<std::vector<reco::Muon> >();  
@@ -114,11 +123,30 @@ TightMuonProducer::produce(edm::Event& iEvent, const edm::EventSetup& iSetup)
    edm::Handle<std::vector<reco::Muon> > muons;
    iEvent.getByLabel(muonCollectionTag_,muons);
 
+   // filled directly, without an intermediate copy
+   std::auto_ptr<std::vector<reco::Muon> > tightMuonCollection( new std::vector<reco::Muon>() );
+   std::vector<reco::Muon>& tightMuons = *tightMuonCollection;
+
+   ++nEvents_;
+   // fast path: both selections require a global muon, no need to look at the vertices otherwise
+   bool hasGlobalMuon = false;
+   for(std::vector<reco::Muon>::const_iterator recomuon_it=muons->begin(); recomuon_it!=muons->end() && !hasGlobalMuon; ++recomuon_it){
+     hasGlobalMuon = recomuon_it->isGlobalMuon();
+   }
+   if ( !hasGlobalMuon ) {
+     ++nNoCandidate_;
+     iEvent.put(tightMuonCollection);
+     return;
+   }
+
    edm::Handle<std::vector<reco::Vertex> > vtx;
    iEvent.getByLabel(vertexCollectionTag_, vtx);
-   const reco::Vertex pv = vtx.product()->operator[](0);
-
-   std::vector<reco::Muon> tightMuons;
+   if ( vtx->empty() ) {
+     ++nNoVertex_;
+     iEvent.put(tightMuonCollection);
+     return;
+   }
+   const reco::Vertex& pv = vtx->front();
 
    for(std::vector<reco::Muon>::const_iterator recomuon_it=muons->begin(); recomuon_it!=muons->end(); ++recomuon_it){
      
@@ -136,7 +164,6 @@ TightMuonProducer::produce(edm::Event& iEvent, const edm::EventSetup& iSetup)
      }
    }      
    // the output
-   std::auto_ptr<std::vector<reco::Muon> > tightMuonCollection( new std::vector<reco::Muon> (tightMuons) );
    iEvent.put(tightMuonCollection);
 
 }
@@ -150,6 +177,9 @@ TightMuonProducer::beginJob()
 // ------------ method called once each job just after ending the event loop  ------------
 void 
 TightMuonProducer::endJob() {
+  edm::LogVerbatim("TightMuonProducer") << "TightMuonProducer: " << nEvents_ << " events, skipped"
+					<< " without global muons (fast path): " << nNoCandidate_
+					<< ", without vertices: " << nNoVertex_;
 }
 
 // ------------ method called when starting to processes a run  ------------
@@ -3,7 +3,7 @@ matchmuonsbytrackerhits = cms.EDProducer("MatchMuonsByTrackerHits",
     # module label
     muonSrc1 = cms.InputTag(''),
     # module label 
-    muonsSrc2 = cms.InputTag(''),
+    muonSrc2 = cms.InputTag(''),
     # minimum shared fraction to be called duplicate
     ShareFrac = cms.double(0.19),
     # best track chosen by chi2 modified by parameters below:
@@ -12,7 +12,9 @@ matchmuonsbytrackerhits = cms.EDProducer("MatchMuonsByTrackerHits",
     # minimum difference in rechit position in cm
     # negative Epsilon uses sharedInput for comparison
     Epsilon = cms.double(-0.001),
-    allowFirstHitShare = cms.bool(True)
+    allowFirstHitShare = cms.bool(True),
+    # threads evaluating the hit overlaps (1 = serial, as the batch jobs get one slot)
+    NumberOfThreads = cms.untracked.int32(1)
 )
 
 
@@ -0,0 +1,20 @@
+import FWCore.ParameterSet.Config as cms
+matchtracksbytrackerhits = cms.EDProducer("MatchTracksByTrackerHits",
+    # module label (same label in trackSrc1 and trackSrc2 = remove the duplicates within the collection)
+    trackSrc1 = cms.InputTag('generalTracks'),
+    # module label 
+    trackSrc2 = cms.InputTag('generalTracks'),
+    # minimum shared fraction to be called duplicate
+    ShareFrac = cms.double(0.19),
+    # best track chosen by chi2 modified by parameters below:
+    FoundHitBonus = cms.double(5.0),
+    LostHitPenalty = cms.double(20.0),
+    # minimum difference in rechit position in cm
+    # negative Epsilon uses sharedInput for comparison
+    Epsilon = cms.double(-0.001),
+    allowFirstHitShare = cms.bool(True),
+    # threads evaluating the hit overlaps (1 = serial, as the batch jobs get one slot)
+    NumberOfThreads = cms.untracked.int32(1)
+)
+
+
@@ -0,0 +1,111 @@
+// -*- C++ -*-
+//
+// Package:    SLHCSimPhase2
+// Program:    edmEventIndex
+//
+/**\file edmEventIndex.cpp
+
+ Description: scans an EDM file once and writes a sidecar index with the number of
+              events, the boundaries of the ROOT entry clusters of the Events tree
+              and the run/lumi/event id of each entry
+
+ Usage:
+     edmEventIndex <input.root> [<output index>]
+     (the index is written to <input.root>.idx by default)
+
+ Format of the index (plain text):
+     input <size> <mtime>                   (of the input file, to detect a regenerated input)
+     entries <N>
+     cluster <first entry> <last entry>     (one line per cluster)
+     event <entry> <run> <lumi> <event>     (one line per entry)
+*/
+//
+// $Id$
+//
+//
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstdio>
+#include <sys/stat.h>
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TBranch.h"
+
+#include "FWCore/FWLite/interface/AutoLibraryLoader.h"
+#include "DataFormats/Provenance/interface/EventAuxiliary.h"
+
+int main(int argc, char* argv[])
+{
+  if ( argc<2 || argc>3 ) {
+    std::cerr << "usage: " << argv[0] << " <input.root> [<output index>]" << std::endl;
+    return 1;
+  }
+  std::string inputName = argv[1];
+  // strip the EDM "file:" prefix, if any
+  if ( inputName.compare(0,5,"file:")==0 ) inputName = inputName.substr(5);
+  std::string indexName = (argc==3) ? argv[2] : inputName+".idx";
+
+  AutoLibraryLoader::enable();
+
+  TFile* file = TFile::Open(inputName.c_str());
+  if ( !file || file->IsZombie() ) {
+    std::cerr << "edmEventIndex: cannot open " << inputName << std::endl;
+    return 2;
+  }
+  TTree* events = dynamic_cast<TTree*>(file->Get("Events"));
+  if ( !events ) {
+    std::cerr << "edmEventIndex: no Events tree in " << inputName << std::endl;
+    return 3;
+  }
+
+  // only the EventAuxiliary branch is read
+  TBranch* auxBranch = events->GetBranch("EventAuxiliary");
+  if ( !auxBranch ) {
+    std::cerr << "edmEventIndex: no EventAuxiliary branch in " << inputName << std::endl;
+    return 3;
+  }
+
+  // write to a temporary file first, so that readers never see a partial index
+  std::string tmpName = indexName+".tmp";
+  std::ofstream index(tmpName.c_str());
+  if ( !index ) {
+    std::cerr << "edmEventIndex: cannot write " << tmpName << std::endl;
+    return 4;
+  }
+
+  struct stat inputStat;
+  if ( stat(inputName.c_str(),&inputStat)!=0 ) {
+    inputStat.st_size = -1;
+    inputStat.st_mtime = -1;
+  }
+  index << "input " << (long long)inputStat.st_size << " " << (long long)inputStat.st_mtime << "\n";
+
+  Long64_t nEntries = events->GetEntries();
+  index << "entries " << nEntries << "\n";
+
+  TTree::TClusterIterator clusters = events->GetClusterIterator(0);
+  Long64_t first;
+  while ( (first = clusters.Next()) < nEntries ) {
+    index << "cluster " << first << " " << clusters.GetNextEntry()-1 << "\n";
+  }
+
+  edm::EventAuxiliary* aux = new edm::EventAuxiliary();
+  auxBranch->SetAddress(&aux);
+  for ( Long64_t entry=0; entry<nEntries; ++entry ) {
+    auxBranch->GetEntry(entry);
+    index << "event " << entry << " " << aux->run() << " " << aux->luminosityBlock() << " " << aux->event() << "\n";
+  }
+  index.close();
+  delete aux;
+  file->Close();
+
+  if ( std::rename(tmpName.c_str(),indexName.c_str())!=0 ) {
+    std::cerr << "edmEventIndex: cannot rename " << tmpName << " to " << indexName << std::endl;
+    return 4;
+  }
+  std::cout << "edmEventIndex: " << nEntries << " events indexed in " << indexName << std::endl;
+  return 0;
+}
@@ -0,0 +1,176 @@
+// -*- C++ -*-
+//
+// Package:    SLHCSimPhase2
+// Class:      JobHeartbeat
+//
+/**\class JobHeartbeat JobHeartbeat.cc AuxCode/SLHCSimPhase2/plugins/JobHeartbeat.cc
+
+ Description: service writing periodically a one-line heartbeat record of the job
+
+ Implementation:
+     Every Interval seconds (checked at each module call) the file HeartbeatFile is
+     rewritten (via a temporary file and a rename, so readers always see a complete
+     record) with: time, events done, expected events, event rate, RSS, the module
+     being run and the job parameters passed in the Parameters PSet. The record is a
+     list of key=value pairs separated by blanks, read by SummarizeHeartbeats.py.
+     When a job runs its range in several cmsRun chunks, EventsOffset gives the events
+     done by the previous chunks and ExpectedEvents the events of the whole range.
+*/
+//
+// $Id$
+//
+//
+
+
+// system include files
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+// user include files
+#include "FWCore/Framework/interface/Frameworkfwd.h"
+#include "FWCore/ServiceRegistry/interface/ActivityRegistry.h"
+#include "FWCore/ServiceRegistry/interface/ServiceMaker.h"
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "DataFormats/Provenance/interface/ModuleDescription.h"
+#include "DataFormats/Provenance/interface/EventID.h"
+#include "DataFormats/Provenance/interface/Timestamp.h"
+
+//
+// class declaration
+//
+
+class JobHeartbeat {
+public:
+  JobHeartbeat(const edm::ParameterSet&, edm::ActivityRegistry&);
+  ~JobHeartbeat();
+
+  void postBeginJob();
+  void postEndJob();
+  void postProcessEvent(const edm::Event&, const edm::EventSetup&);
+  void preModule(const edm::ModuleDescription&);
+
+private:
+  void write(const char* status);
+  static double rssMB();
+
+  // ----------member data ---------------------------
+  std::string fileName_;
+  std::string tmpName_;
+  int interval_;
+  int expectedEvents_;
+  unsigned long long eventsOffset_;
+  std::string parameters_;
+
+  time_t startTime_;
+  time_t lastWrite_;
+  unsigned long long nEvents_;
+  std::string currentModule_;
+};
+
+//
+// constructors and destructor
+//
+JobHeartbeat::JobHeartbeat(const edm::ParameterSet& iConfig, edm::ActivityRegistry& iRegistry):
+fileName_(iConfig.getUntrackedParameter<std::string>("HeartbeatFile")),
+tmpName_(fileName_+".tmp"),
+interval_(iConfig.getUntrackedParameter<int>("Interval",60)),
+expectedEvents_(iConfig.getUntrackedParameter<int>("ExpectedEvents",-1)),
+eventsOffset_(iConfig.getUntrackedParameter<unsigned int>("EventsOffset",0)),
+startTime_(time(0)),
+lastWrite_(0),
+nEvents_(0),
+currentModule_("none")
+{
+  // the job parameters (pileup, ageing, thresholds...) are copied as they are in the record
+  edm::ParameterSet pars = iConfig.getUntrackedParameter<edm::ParameterSet>("Parameters",edm::ParameterSet());
+  std::vector<std::string> names = pars.getParameterNames();
+  for ( std::vector<std::string>::const_iterator name=names.begin(); name!=names.end(); ++name ) {
+    parameters_ += " "+*name+"="+pars.getUntrackedParameter<std::string>(*name);
+  }
+
+  iRegistry.watchPostBeginJob(this,&JobHeartbeat::postBeginJob);
+  iRegistry.watchPostEndJob(this,&JobHeartbeat::postEndJob);
+  iRegistry.watchPostProcessEvent(this,&JobHeartbeat::postProcessEvent);
+  iRegistry.watchPreModule(this,&JobHeartbeat::preModule);
+}
+
+
+JobHeartbeat::~JobHeartbeat()
+{
+}
+
+
+//
+// member functions
+//
+
+// ------------ resident memory of the job in MB  ------------
+double
+JobHeartbeat::rssMB()
+{
+  long pages = 0, rss = 0;
+  FILE* statm = fopen("/proc/self/statm","r");
+  if ( !statm ) return -1.;
+  if ( fscanf(statm,"%ld %ld",&pages,&rss)!=2 ) rss = -1;
+  fclose(statm);
+  return rss<0 ? -1. : rss*(sysconf(_SC_PAGESIZE)/1048576.);
+}
+
+// ------------ writes the heartbeat record  ------------
+void
+JobHeartbeat::write(const char* status)
+{
+  time_t now = time(0);
+  lastWrite_ = now;
+  double elapsed = difftime(now,startTime_);
+  double rate = elapsed>0 ? nEvents_/elapsed : 0.;
+
+  std::ofstream record(tmpName_.c_str());
+  if ( !record ) return;
+  record << "time=" << now
+	 << " start=" << startTime_
+	 << " status=" << status
+	 << " events=" << eventsOffset_+nEvents_
+	 << " expected=" << expectedEvents_
+	 << " rate=" << rate
+	 << " rssMB=" << rssMB()
+	 << " module=" << currentModule_
+	 << parameters_ << "\n";
+  record.close();
+  std::rename(tmpName_.c_str(),fileName_.c_str());
+}
+
+void
+JobHeartbeat::postBeginJob()
+{
+  startTime_ = time(0);
+  write("running");
+}
+
+void
+JobHeartbeat::postEndJob()
+{
+  currentModule_ = "none";
+  bool finished = expectedEvents_<0 || eventsOffset_+nEvents_>=(unsigned long long)expectedEvents_;
+  write(finished ? "done" : "paused");
+}
+
+void
+JobHeartbeat::postProcessEvent(const edm::Event&, const edm::EventSetup&)
+{
+  ++nEvents_;
+}
+
+void
+JobHeartbeat::preModule(const edm::ModuleDescription& description)
+{
+  currentModule_ = description.moduleLabel();
+  if ( difftime(time(0),lastWrite_)>=interval_ ) write("running");
+}
+
+//define this as a service
+DEFINE_FWK_SERVICE(JobHeartbeat);
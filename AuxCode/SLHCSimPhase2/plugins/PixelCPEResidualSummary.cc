@@ -0,0 +1,305 @@
+// -*- C++ -*-
+//
+// Package:    PixelCPEResidualSummary
+// Class:      PixelCPEResidualSummary
+//
+/**\class PixelCPEResidualSummary PixelCPEResidualSummary.cc AuxCode/SLHCSimPhase2/plugins/PixelCPEResidualSummary.cc
+
+ Description: residual and pull distributions of the pixel rechits w.r.t. the associated simhits,
+              accumulated online per layer/disk, module orientation and cluster size
+
+ Implementation:
+     The distributions are finely binned histograms booked via TFileService, so that the
+     outputs of different jobs can be merged with hadd. Only the distributions are written:
+     the median and the 68% half-width vs cluster size are computed on the merged file by
+     test/PixelCPEResidualQuantiles.py. A per-hit ntuple is still available, prescaled by
+     PerHitPrescale (0 switches it off).
+*/
+//
+// $Id$
+//
+//
+
+
+// system include files
+#include <memory>
+#include <map>
+#include <cmath>
+#include <algorithm>
+
+// user include files
+#include "FWCore/Framework/interface/Frameworkfwd.h"
+#include "FWCore/Framework/interface/EDAnalyzer.h"
+
+#include "FWCore/Framework/interface/Event.h"
+#include "FWCore/Framework/interface/EventSetup.h"
+#include "FWCore/Framework/interface/ESHandle.h"
+#include "FWCore/Framework/interface/MakerMacros.h"
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "FWCore/ServiceRegistry/interface/Service.h"
+#include "CommonTools/UtilAlgos/interface/TFileService.h"
+
+#include "DataFormats/Common/interface/Handle.h"
+#include "DataFormats/DetId/interface/DetId.h"
+#include "DataFormats/SiPixelDetId/interface/PixelSubdetector.h"
+#include "DataFormats/SiPixelDetId/interface/PXBDetId.h"
+#include "DataFormats/SiPixelDetId/interface/PXFDetId.h"
+#include "DataFormats/TrackerRecHit2D/interface/SiPixelRecHitCollection.h"
+
+#include "SimDataFormats/TrackingHit/interface/PSimHit.h"
+#include "SimTracker/TrackerHitAssociation/interface/TrackerHitAssociator.h"
+
+#include "Geometry/CommonDetUnit/interface/GeomDet.h"
+#include "Geometry/TrackerGeometryBuilder/interface/TrackerGeometry.h"
+#include "Geometry/Records/interface/TrackerDigiGeometryRecord.h"
+
+#include <TH1F.h>
+#include <TString.h>
+#include <TTree.h>
+
+//
+// class declaration
+//
+
+class PixelCPEResidualSummary : public edm::EDAnalyzer {
+public:
+  explicit PixelCPEResidualSummary(const edm::ParameterSet&);
+  ~PixelCPEResidualSummary();
+
+  static void fillDescriptions(edm::ConfigurationDescriptions& descriptions);
+
+private:
+  virtual void beginJob() ;
+  virtual void analyze(const edm::Event&, const edm::EventSetup&);
+  virtual void endJob() ;
+
+  // histograms of one category (subdetector, layer/disk, orientation)
+  struct CategoryHistos {
+    std::vector<TH1F*> resX;   // one per cluster size along x
+    std::vector<TH1F*> resY;   // one per cluster size along y
+    std::vector<TH1F*> pullX;
+    std::vector<TH1F*> pullY;
+    TFileDirectory* dir;
+  };
+
+  CategoryHistos& category(unsigned int subdet, unsigned int layer, bool flipped);
+
+  // ----------member data ---------------------------
+  edm::Service<TFileService> p_fileservice;
+
+  edm::ParameterSet conf_;
+  edm::InputTag pixelRecHitsTag_;
+
+  unsigned int maxClusterSize_;
+  double residualRange_;
+  int residualBins_;
+  double pullRange_;
+  int pullBins_;
+  unsigned int perHitPrescale_;
+
+  std::map<unsigned int, CategoryHistos> categories_;
+
+  // prescaled per-hit ntuple
+  TTree * p_tree;
+  unsigned long long nHits_;
+  int   t_subdet, t_layer, t_flipped, t_sizeX, t_sizeY;
+  float t_resX, t_resY, t_pullX, t_pullY;
+  float t_recX, t_recY, t_simX, t_simY;
+
+};
+
+//
+// constants, enums and typedefs
+//
+namespace {
+  const double cmToUm = 10000.;
+}
+
+//
+// static data member definitions
+//
+
+//
+// constructors and destructor
+//
+PixelCPEResidualSummary::PixelCPEResidualSummary(const edm::ParameterSet& iConfig):
+conf_(iConfig),
+pixelRecHitsTag_(iConfig.getParameter<edm::InputTag>("src")),
+maxClusterSize_(iConfig.getParameter<unsigned int>("MaxClusterSize")),
+residualRange_(iConfig.getParameter<double>("ResidualRange")),
+residualBins_(iConfig.getParameter<int>("ResidualBins")),
+pullRange_(iConfig.getParameter<double>("PullRange")),
+pullBins_(iConfig.getParameter<int>("PullBins")),
+perHitPrescale_(iConfig.getParameter<unsigned int>("PerHitPrescale")),
+p_tree(0),
+nHits_(0)
+{
+  // the last bin collects the clusters of size >= MaxClusterSize
+  if ( maxClusterSize_==0 ) {
+    throw cms::Exception("Configuration") << "PixelCPEResidualSummary: MaxClusterSize must be at least 1";
+  }
+}
+
+
+PixelCPEResidualSummary::~PixelCPEResidualSummary()
+{
+  for(std::map<unsigned int, CategoryHistos>::iterator it=categories_.begin(); it!=categories_.end(); ++it){
+    delete it->second.dir;
+  }
+}
+
+
+//
+// member functions
+//
+
+// ------------ books (on first use) the histograms of a category  ------------
+PixelCPEResidualSummary::CategoryHistos&
+PixelCPEResidualSummary::category(unsigned int subdet, unsigned int layer, bool flipped)
+{
+  unsigned int key = subdet*1000 + layer*10 + (flipped ? 1 : 0);
+  std::map<unsigned int, CategoryHistos>::iterator it = categories_.find(key);
+  if ( it!=categories_.end() ) return it->second;
+
+  std::string name;
+  if ( subdet==PixelSubdetector::PixelBarrel ) {
+    name = Form("BPix_Layer%u_%s", layer, flipped ? "Flipped" : "NonFlipped");
+  } else {
+    name = Form("FPix_Disk%u", layer);
+  }
+
+  CategoryHistos& h = categories_[key];
+  h.dir = new TFileDirectory(p_fileservice->mkdir(name));
+  for ( unsigned int size=1; size<=maxClusterSize_; ++size ) {
+    std::string sizeLabel = (size<maxClusterSize_) ? Form("%u",size) : Form("%uplus",size);
+    h.resX.push_back(h.dir->make<TH1F>(("resX_size"+sizeLabel).c_str(), (name+" x residual, size_{x}="+sizeLabel+";x_{rec}-x_{sim} [#mum];hits").c_str(),
+				       residualBins_, -residualRange_, residualRange_));
+    h.resY.push_back(h.dir->make<TH1F>(("resY_size"+sizeLabel).c_str(), (name+" y residual, size_{y}="+sizeLabel+";y_{rec}-y_{sim} [#mum];hits").c_str(),
+				       residualBins_, -residualRange_, residualRange_));
+    h.pullX.push_back(h.dir->make<TH1F>(("pullX_size"+sizeLabel).c_str(), (name+" x pull, size_{x}="+sizeLabel+";(x_{rec}-x_{sim})/#sigma_{x};hits").c_str(),
+					pullBins_, -pullRange_, pullRange_));
+    h.pullY.push_back(h.dir->make<TH1F>(("pullY_size"+sizeLabel).c_str(), (name+" y pull, size_{y}="+sizeLabel+";(y_{rec}-y_{sim})/#sigma_{y};hits").c_str(),
+					pullBins_, -pullRange_, pullRange_));
+  }
+  return h;
+}
+
+// ------------ method called for each event  ------------
+void
+PixelCPEResidualSummary::analyze(const edm::Event& iEvent, const edm::EventSetup& iSetup)
+{
+   using namespace edm;
+
+   edm::Handle<SiPixelRecHitCollection> recHits;
+   iEvent.getByLabel(pixelRecHitsTag_, recHits);
+
+   edm::ESHandle<TrackerGeometry> geom;
+   iSetup.get<TrackerDigiGeometryRecord>().get(geom);
+
+   TrackerHitAssociator associator(iEvent, conf_);
+
+   for (SiPixelRecHitCollection::const_iterator detset=recHits->begin(); detset!=recHits->end(); ++detset){
+     DetId detId(detset->detId());
+     unsigned int subdet = detId.subdetId();
+     unsigned int layer = 0;
+     bool flipped = false;
+     if ( subdet==PixelSubdetector::PixelBarrel ) {
+       layer = PXBDetId(detId).layer();
+       // a module is flipped when its local z axis points inward
+       const GeomDet* det = geom->idToDet(detId);
+       float rOrigin = det->surface().toGlobal(LocalPoint(0.,0.,0.)).perp();
+       float rZAxis  = det->surface().toGlobal(LocalPoint(0.,0.,1.)).perp();
+       flipped = rZAxis < rOrigin;
+     } else if ( subdet==PixelSubdetector::PixelEndcap ) {
+       layer = PXFDetId(detId).disk();
+     } else {
+       continue;
+     }
+     CategoryHistos& h = category(subdet, layer, flipped);
+
+     for (SiPixelRecHitCollection::DetSet::const_iterator hit=detset->begin(); hit!=detset->end(); ++hit){
+       std::vector<PSimHit> simHits = associator.associateHit(*hit);
+       if ( simHits.empty() ) continue;
+
+       // take the closest simhit
+       LocalPoint rec = hit->localPosition();
+       std::vector<PSimHit>::const_iterator closest = simHits.begin();
+       float minDist = 1e9;
+       for (std::vector<PSimHit>::const_iterator sim=simHits.begin(); sim!=simHits.end(); ++sim){
+	 float dist = (rec - sim->localPosition()).mag();
+	 if ( dist<minDist ) { minDist = dist; closest = sim; }
+       }
+       LocalPoint sim = closest->localPosition();
+
+       float resX = (rec.x()-sim.x())*cmToUm;
+       float resY = (rec.y()-sim.y())*cmToUm;
+       float errX = sqrt(hit->localPositionError().xx())*cmToUm;
+       float errY = sqrt(hit->localPositionError().yy())*cmToUm;
+       float pullX = errX>0 ? resX/errX : 0.;
+       float pullY = errY>0 ? resY/errY : 0.;
+
+       int sizeX = hit->cluster()->sizeX();
+       int sizeY = hit->cluster()->sizeY();
+       unsigned int binX = std::min<unsigned int>(sizeX, maxClusterSize_) - 1;
+       unsigned int binY = std::min<unsigned int>(sizeY, maxClusterSize_) - 1;
+
+       h.resX[binX]->Fill(resX);
+       h.pullX[binX]->Fill(pullX);
+       h.resY[binY]->Fill(resY);
+       h.pullY[binY]->Fill(pullY);
+
+       ++nHits_;
+       if ( p_tree && (nHits_ % perHitPrescale_)==0 ) {
+	 t_subdet = subdet; t_layer = layer; t_flipped = flipped;
+	 t_sizeX = sizeX; t_sizeY = sizeY;
+	 t_resX = resX; t_resY = resY; t_pullX = pullX; t_pullY = pullY;
+	 t_recX = rec.x(); t_recY = rec.y(); t_simX = sim.x(); t_simY = sim.y();
+	 p_tree->Fill();
+       }
+     }
+   }
+}
+
+// ------------ method called once each job just before starting event loop  ------------
+void
+PixelCPEResidualSummary::beginJob()
+{
+  if ( perHitPrescale_>0 ) {
+    p_tree = p_fileservice->make<TTree>("PixelHits", "prescaled per-hit pixel residuals");
+    p_tree->Branch("subdet",  &t_subdet,  "subdet/I");
+    p_tree->Branch("layer",   &t_layer,   "layer/I");
+    p_tree->Branch("flipped", &t_flipped, "flipped/I");
+    p_tree->Branch("sizeX",   &t_sizeX,   "sizeX/I");
+    p_tree->Branch("sizeY",   &t_sizeY,   "sizeY/I");
+    p_tree->Branch("resX",    &t_resX,    "resX/F");
+    p_tree->Branch("resY",    &t_resY,    "resY/F");
+    p_tree->Branch("pullX",   &t_pullX,   "pullX/F");
+    p_tree->Branch("pullY",   &t_pullY,   "pullY/F");
+    p_tree->Branch("recX",    &t_recX,    "recX/F");
+    p_tree->Branch("recY",    &t_recY,    "recY/F");
+    p_tree->Branch("simX",    &t_simX,    "simX/F");
+    p_tree->Branch("simY",    &t_simY,    "simY/F");
+  }
+}
+
+// ------------ method called once each job just after ending the event loop  ------------
+void
+PixelCPEResidualSummary::endJob()
+{
+}
+
+// ------------ method fills 'descriptions' with the allowed parameters for the module  ------------
+void
+PixelCPEResidualSummary::fillDescriptions(edm::ConfigurationDescriptions& descriptions) {
+  //The following says we do not know what parameters are allowed so do no validation
+  // Please change this to state exactly what you do use, even if it is no parameters
+  edm::ParameterSetDescription desc;
+  desc.setUnknown();
+  descriptions.addDefault(desc);
+}
+
+//define this as a plug-in
+DEFINE_FWK_MODULE(PixelCPEResidualSummary);
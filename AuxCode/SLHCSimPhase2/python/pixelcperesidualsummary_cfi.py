@@ -0,0 +1,22 @@
+import FWCore.ParameterSet.Config as cms
+pixelcperesidualsummary = cms.EDAnalyzer("PixelCPEResidualSummary",
+    # pixel rechits to be compared with the simhits
+    src = cms.InputTag("siPixelRecHits"),
+    # the last cluster size bin collects all the larger clusters
+    MaxClusterSize = cms.uint32(6),
+    # residuals in um, 1 um bins
+    ResidualRange = cms.double(500.),
+    ResidualBins = cms.int32(1000),
+    PullRange = cms.double(10.),
+    PullBins = cms.int32(200),
+    # write one hit every PerHitPrescale to the per-hit ntuple (0 = no ntuple)
+    PerHitPrescale = cms.uint32(0),
+    # track hit association
+    associatePixel = cms.bool(True),
+    associateStrip = cms.bool(False),
+    associateRecoTracks = cms.bool(False),
+    ROUList = cms.vstring('g4SimHitsTrackerHitsPixelBarrelLowTof',
+                          'g4SimHitsTrackerHitsPixelBarrelHighTof',
+                          'g4SimHitsTrackerHitsPixelEndcapLowTof',
+                          'g4SimHitsTrackerHitsPixelEndcapHighTof')
+)
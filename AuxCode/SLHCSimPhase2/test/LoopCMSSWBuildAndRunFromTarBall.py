@@ -19,6 +19,7 @@ def set_global_var():
     global CMSSW_VER
 
     global GENSIM_FILE
+    global PILEUP_FILE
 
     USER = os.environ.get('USER')
     HOME = os.environ.get('HOME')
@@ -28,20 +29,87 @@ def set_global_var():
     CMSSW_VER="CMSSW_6_1_2_SLHC4_patch1"
     GENSIM_FILE = "file:/lustre/cms/store/user/musich/SLHCSimPhase2/Samples/TTbar/step1_TTtoAnything_14TeV_pythia6_15k_evts.root"
     # GENSIM_FILE="file:/lustre/cms/store/user/traverso/UpgradeSamples/step1_TTtoAnything_1k_evts.root"
+    PILEUP_FILE = "file:/lustre/cms/store/user/musich/SLHCSimPhase2/Samples/MinBias/step1_MinBias_TuneZ2star_14TeV_pythia6_15k_evts.root"
 
     
+###########################################################################
+def read_event_index(filename,indexdir):
+###########################################################################
+    """reads the index written by edmEventIndex (creating it if needed):
+    returns the number of events and the first entries of the ROOT clusters.
+    The index is kept in indexdir, since the input may be in another user's area"""
+
+    indexname = os.path.join(indexdir,os.path.basename(filename.replace("file:",""))+".idx")
+    if os.path.exists(indexname) and not index_matches_input(indexname,filename):
+        print "input changed since", indexname, "was written, rebuilding it"
+        os.remove(indexname)
+    if not os.path.exists(indexname):
+        if not os.path.exists(indexdir):
+            os.makedirs(indexdir)
+        os.system("edmEventIndex "+filename+" "+indexname)
+    if not os.path.exists(indexname):
+        print "no event index for", filename
+        return None,[]
+
+    nEvents = None
+    clusters = []
+    for line in open(indexname):
+        fields = line.split()
+        if len(fields)==0: continue
+        if fields[0]=="entries":
+            nEvents = int(fields[1])
+        elif fields[0]=="cluster":
+            clusters.append(int(fields[1]))
+        elif fields[0]=="event":
+            break
+    return nEvents,clusters
+
+###########################################################################
+def index_matches_input(indexname,filename):
+###########################################################################
+    """the index was written for the current version of the input (same size and mtime)"""
+    try:
+        inputstat = os.stat(filename.replace("file:",""))
+    except OSError:
+        return False
+    fields = open(indexname).readline().split()
+    return len(fields)==3 and fields[0]=="input" and int(fields[1])==inputstat.st_size and int(fields[2])==int(inputstat.st_mtime)
+
+###########################################################################
+def align_to_cluster(entry,clusters,nEvents):
+###########################################################################
+    """first cluster boundary at or after entry"""
+    for first in clusters:
+        if first>=entry:
+            return first
+    return max(entry,nEvents) if len(clusters)>0 else entry
+
+###########################################################################
+def split_range(first,last,size,clusters,nEvents):
+###########################################################################
+    """boundaries of the pieces of about size entries of [first,last), moved to the
+    next ROOT cluster so that each piece starts reading a fresh basket
+    (the last element is last)"""
+    boundaries=[]
+    entry=first
+    while entry<last:
+        boundaries.append(entry)
+        entry = min(last,align_to_cluster(entry+size,clusters,nEvents))
+    boundaries.append(last)
+    return boundaries
+
 ###########################################################################
 class Job:
     """Main class to create and submit PBS jobs"""
 ###########################################################################
 
-    def __init__(self, job_id,firstevent,maxevents, sample, pu, ageing, pixelrocrows, pixelroccols, bpixthr, the_dir):
+    def __init__(self, job_id,firstevent,maxevents, sample, pu, ageing, pixelrocrows, pixelroccols, bpixthr, eventcontent, prune, chunkstarts, nodecache, the_dir):
 ############################################################################################################################
         
         # store the job-ID (since it is created in a for loop)
         self.job_id=job_id
         
-        # first/max event used in this job
+        # first/max event used in this job (firstevent-1 entries are skipped in the input file)
         self.firstevent=firstevent
         self.maxevents=maxevents
 
@@ -54,6 +122,20 @@ class Job:
         self.pixelroccols=pixelroccols
         self.bpixthr=bpixthr
         self.ageing=ageing
+
+        # content of the EDM output file
+        self.eventcontent=eventcontent
+
+        # remove the producers not needed by the tracker validation
+        self.prune=prune
+
+        # first entries of the checkpoints, aligned to the ROOT clusters (the last one is the end
+        # of the range): the output files are closed, copied out and recorded in the manifest
+        # at each of them
+        self.chunkstarts=chunkstarts
+
+        # read the pileup file from a copy shared by the jobs on the same node
+        self.nodecache=nodecache
         
         self.the_dir=the_dir  # this is the working 
         self.out_dir=os.path.join("/lustre/cms/store/user",USER,"SLHCSimPhase2/out","sample_"+sample,"pu_"+pu,"PixelROCRows_" +pixelrocrows+"_PixelROCCols_"+pixelroccols,"BPixThr_"+bpixthr)
@@ -61,6 +143,12 @@ class Job:
 
         self.job_basename= 'step_digitodqm_' +self.sample+ '_pu' + self.pu + '_age' + self.ageing + '_' + str(self.firstevent)+ "_PixelROCRows" + self.pixelrocrows + "_PixelROCCols" + self.pixelroccols + "_BPixThr" + self.bpixthr
         
+        self.manifest=os.path.join(self.out_dir,self.job_basename+".manifest")
+
+        # heartbeat records of all the jobs of the campaign, summarized by SummarizeHeartbeats.py
+        self.heartbeat_dir=os.path.join("/lustre/cms/store/user",USER,"SLHCSimPhase2/heartbeat",job_id)
+        os.system("mkdir -p "+self.heartbeat_dir)
+
         self.cfg_dir=None
         self.outputPSetName=None
 
@@ -77,6 +165,7 @@ class Job:
             os.makedirs(self.pbs_dir)
 
         self.output_PBS_name=self.job_basename+".pbs"
+
         fout=open(os.path.join(self.pbs_dir,'jobs',self.output_PBS_name),'w')
     
         LOG_dir = os.path.join(self.the_dir,"log")
@@ -92,16 +181,21 @@ class Job:
         fout.write("#PBS -l mem=5gb \n")
         fout.write("### Auto-Generated Script by LoopCMSSWBuildAndRunFromTarBall.py ### \n")
         fout.write("JobName="+self.job_basename+" \n")
-        fout.write("outfilename="+self.job_basename+".root"+" \n")
         fout.write("OUT_DIR="+self.out_dir+" \n")
-        fout.write("firstevent="+str(self.firstevent)+" \n")
+        fout.write("skipevents="+str(self.firstevent-1)+" \n")
         fout.write("maxevents="+str(self.maxevents)+" \n")
+        fout.write("chunkstarts=\""+" ".join([str(e) for e in self.chunkstarts])+"\" \n")
+        fout.write("manifest="+self.manifest+" \n")
+        fout.write("heartbeat="+os.path.join(self.heartbeat_dir,self.job_basename+".hb")+" \n")
         fout.write("pixelroccols="+self.pixelroccols+" \n")
         fout.write("pixelrocrows="+self.pixelrocrows+" \n")
         fout.write("puscenario="+self.pu+" \n")
         fout.write("ageing="+self.ageing+" \n")
         fout.write("bpixthr="+self.bpixthr+" \n")
+        fout.write("eventcontent="+self.eventcontent+" \n")
+        fout.write("pruneschedule="+str(int(self.prune))+" \n")
         fout.write("inputgensimfilename="+GENSIM_FILE+" \n")
+        fout.write("pileupfilename="+PILEUP_FILE+" \n")
         
 
 # specific for cmssusy.ba.infn.it
@@ -152,20 +246,90 @@ class Job:
         fout.write("cd ${CMSSW_BASE}/test \n")
         fout.write("cp -v "+os.path.join(HOME,"SLHCSimPhase2","AuxFiles","scripts","step_digitodqmvalidation_PUandAge.py")+" . \n")  
         fout.write("cp -v "+os.path.join(HOME,"SLHCSimPhase2","AuxFiles","scripts","TkOnlyValidationCustoms.py")+" . \n") 
-        fout.write("cmsRun step_digitodqmvalidation_PUandAge.py maxEvents=${maxevents} firstEvent=${firstevent} BPixThr=${bpixthr} InputFileName=${inputgensimfilename} OutFileName=${outfilename} PUScenario=${puscenario} AgeingScenario=${ageing} \n")
-        fout.write("ls -lh \n")
-        fout.write(" # retrieve the outputs \n")
-        fout.write("for RootOutputFile in $(ls *root ); do rfcp  ${RootOutputFile}  ${OUT_DIR}/${RootOutputFile} ; done \n")
+        fout.write("cp -v "+os.path.join(HOME,"SLHCSimPhase2","AuxFiles","scripts","TkOnlyEventContent.py")+" . \n") 
+        if self.nodecache:
+            fout.write("# the mixing module reads the MinBias file across its whole length: read it from the node-local \n")
+            fout.write("# cache shared with the other jobs on this node (the GEN-SIM file is read directly, each job \n")
+            fout.write("# only reads its own range of it) \n")
+            fout.write("if [ \"${puscenario}\" != \"NoPU\" ]; then \n")
+            fout.write("  cp -v "+os.path.join(HOME,"SLHCSimPhase2","AuxFiles","scripts","NodeLocalInputCache.sh")+" . \n")
+            fout.write("  origpileupfilename=${pileupfilename} \n")
+            fout.write("  trap \"sh ${PWD}/NodeLocalInputCache.sh release ${origpileupfilename} $$\" EXIT \n")
+            fout.write("  pileupfilename=$(sh NodeLocalInputCache.sh acquire ${origpileupfilename} $$) \n")
+            fout.write("fi \n")
+        fout.write("# the range is processed in the chunks starting at ${chunkstarts}: each chunk is copied out \n")
+        fout.write("# and recorded in the manifest as soon as it is done, chunks already in the manifest \n")
+        fout.write("# (same first entry and number of events) are skipped \n")
+        fout.write("touch ${manifest} \n")
+        fout.write("done_events=0 \n")
+        fout.write("set -- ${chunkstarts} \n")
+        fout.write("nchunks=$(($#-1)) \n")
+        fout.write("while [ $# -gt 1 ]; do \n")
+        fout.write("  nchunk=$(($2-$1)) \n")
+        fout.write("  # a job in a single chunk keeps the output names of the jobs without checkpoints \n")
+        fout.write("  if [ ${nchunks} -eq 1 ]; then chunkname=${JobName}; else chunkname=${JobName}_chunk$1_${nchunk}; fi \n")
+        fout.write("  dqmchunkname=$(echo ${chunkname} | sed 's/digitodqm/digitodqm_inDQM/') \n")
+        fout.write("  if awk -v first=$1 -v n=${nchunk} '$2==first && $3==n {found=1} END {exit !found}' ${manifest}; then \n")
+        fout.write("    echo \"${chunkname} already done\" \n")
+        fout.write("  else \n")
+        fout.write("    cmsRun step_digitodqmvalidation_PUandAge.py maxEvents=${nchunk} skipEvents=$1 BPixThr=${bpixthr} InputFileName=${inputgensimfilename} PileupFileName=${pileupfilename} OutFileName=${chunkname}.root PUScenario=${puscenario} AgeingScenario=${ageing} EventContent=${eventcontent} PruneSchedule=${pruneschedule} HeartbeatFile=${heartbeat} HeartbeatEventsDone=${done_events} HeartbeatEventsExpected=${maxevents} || exit 1 \n")
+        fout.write("    ls -lh \n")
+        fout.write("    # per-branch size of the output, to compare the written volume \n")
+        fout.write("    edmEventSize -v ${chunkname}.root > ${chunkname}_EventSize.txt \n")
+        fout.write("    # retrieve the outputs of the chunk and record it \n")
+        fout.write("    rfcp ${chunkname}.root ${OUT_DIR}/${chunkname}.root || exit 1 \n")
+        fout.write("    rfcp ${dqmchunkname}.root ${OUT_DIR}/${dqmchunkname}.root || exit 1 \n")
+        fout.write("    rfcp ${chunkname}_EventSize.txt ${OUT_DIR} \n")
+        fout.write("    echo \"${chunkname} $1 ${nchunk} ${dqmchunkname}.root\" >> ${manifest} \n")
+        fout.write("    rm -f ${chunkname}.root ${dqmchunkname}.root \n")
+        fout.write("  fi \n")
+        fout.write("  done_events=$((done_events+nchunk)) \n")
+        fout.write("  shift \n")
+        fout.write("done \n")
         fout.write("rfcp step_digitodqmvalidation_PUandAge.py ${OUT_DIR} \n")
         fout.write("# rfcp ${CMSSW_BASE}/src/SLHCUpgradeSimulations/Geometry/data/PhaseI/PixelSkimmedGeometry_phase1.txt ${OUT_DIR} \n")
         fout.write("# rfcp ${CMSSW_BASE}/src/Geometry/TrackerCommonData/data/PhaseI/trackerStructureTopology.xml ${OUT_DIR} \n")
         fout.close()
 
+############################################
+    def writeQueuedHeartbeat(self):
+############################################
+        # same fields and job parameters as the records of the JobHeartbeat service
+        # (on resubmission the events already in the manifest are counted as done)
+        now=int(time.time())
+        record=open(os.path.join(self.heartbeat_dir,self.job_basename+".hb"),'w')
+        record.write("time="+str(now)+" start="+str(now)+" status=queued events="+str(self.doneEvents())+" expected="+str(self.maxevents)+" rate=0 rssMB=0 module=none")
+        record.write(" PUScenario="+self.pu+" AgeingScenario="+self.ageing+" BPixThr="+self.bpixthr+"\n")
+        record.close()
+
+############################################
+    def doneEvents(self):
+############################################
+        # events of the chunks of the range already recorded in the manifest (chunks of
+        # a different chunking, or recorded twice by a resubmitted job, are not counted)
+        chunks=set(zip(self.chunkstarts[:-1],[b-a for a,b in zip(self.chunkstarts[:-1],self.chunkstarts[1:])]))
+        done=set()
+        if os.path.exists(self.manifest):
+            for line in open(self.manifest):
+                fields=line.split()
+                if len(fields)==4 and (int(fields[1]),int(fields[2])) in chunks:
+                    done.add((int(fields[1]),int(fields[2])))
+        return sum([n for first,n in done])
+
+############################################
+    def isComplete(self):
+############################################
+        # all the events of the range are recorded in the manifest
+        return self.doneEvents()>=self.maxevents
+
 ############################################
     def submit(self):
 ############################################
         os.system("chmod u+x " + os.path.join(self.pbs_dir,'jobs',self.output_PBS_name))
         os.system("qsub < "+os.path.join(self.pbs_dir,'jobs',self.output_PBS_name))
+        # the heartbeat service only writes once cmsRun has started: a first record makes
+        # the queued jobs (and the ones still compiling) visible to SummarizeHeartbeats.py
+        self.writeQueuedHeartbeat()
 
 
 
@@ -184,6 +348,10 @@ def main():
     parser.add_option('-p','--pileup',help='set pileup',dest='pu',action='store',default='NoPU')
     parser.add_option('-S','--sample',help='set sample name',dest='sample',action='store',default='TTbar')
     parser.add_option('-a','--ageing',help='set ageing',dest='ageing',action='store',default='NoAgeing')
+    parser.add_option('-e','--eventcontent',help='set output event content (FEVTDEBUGHLT or TkOnly)',dest='eventcontent',action='store',default='FEVTDEBUGHLT')
+    parser.add_option('-P','--prune',help='remove the producers not needed by the tracker validation (needs -e TkOnly)', dest='prune', action='store_true', default=False)
+    parser.add_option('-N','--nodecache',help='share the pileup file between the jobs of the same node', dest='nodecache', action='store_true', default=False)
+    parser.add_option('-k','--chunk',help='events per checkpoint of each job (0 = no checkpoint)', dest='chunkevents', action='store', default='0')
     (opts, args) = parser.parse_args()
 
 # check that chosen pixel size matches what is currently available in the trackerStructureTopology
@@ -196,6 +364,11 @@ def main():
         print "illegal value for PixelROCCols"
     exit
 
+    # the pruning does not follow the wildcard keep statements of the full content
+    if opts.prune and opts.eventcontent!="TkOnly":
+        print "-P/--prune needs -e TkOnly"
+        sys.exit(1)
+
     # Set global variables
     set_global_var()
 
@@ -207,49 +380,63 @@ def main():
     os.system("eval `scram r -sh`")
 
     # Split and submit
-    child_edm = subprocess.Popen(["edmEventSize","-v",GENSIM_FILE],stdout=subprocess.PIPE)
-    (out,err) = child_edm.communicate()
+    # the event index gives the number of events and the cluster boundaries without reading the file
+    (nEvents,clusters) = read_event_index(GENSIM_FILE,os.path.join("/lustre/cms/store/user",USER,"SLHCSimPhase2/index"))
+    if nEvents is None:
+        child_edm = subprocess.Popen(["edmEventSize","-v",GENSIM_FILE],stdout=subprocess.PIPE)
+        (out,err) = child_edm.communicate()
+        nEvents = int((out.split("\n")[1]).split()[3])
 
     ### uncomment next to debug the script on 50 events
 #    nEvents=100 # this line should be commented for running on the full GEN-SIM sample
-    nEvents = int((out.split("\n")[1]).split()[3])
 
     print nEvents, opts.numberofjobs          
                                          
-    eventsPerJob = nEvents/int(opts.numberofjobs)
+    eventsPerJob = max(1,nEvents/int(opts.numberofjobs))
     print eventsPerJob
-    remainder=nEvents
-    firstEvent=1
+
+    # job boundaries, moved to the next ROOT cluster so that each job starts reading a fresh basket
+    firstEntries = split_range(0,nEvents,eventsPerJob,clusters,nEvents)
     jobIndex=0
     
-    #prepare the list of the DQM files for the harvesting
-    DQMFileList=""
+    #prepare the list of the manifests of the DQM files for the harvesting
+    ManifestList=""
+    # and the chunks (first:events) of the current splitting, so that the chunks of an older one are ignored
+    ChunkList=""
 
     os.chdir(os.path.join(HOME,"SLHCSimPhase2","AuxFiles"))
     the_dir = os.getcwd()
     out_dir = None
 
     # ###########################
-    while remainder>0:
+    while jobIndex<len(firstEntries)-1:
 
-        print firstEvent
+        firstEvent = firstEntries[jobIndex]+1
+        maxEvents  = firstEntries[jobIndex+1]-firstEntries[jobIndex]
+        print firstEvent, maxEvents
         
-        ajob=Job(opts.jobname, firstEvent, eventsPerJob, opts.sample, opts.pu, opts.ageing, opts.rocrows, opts.roccols, opts.bpixthr, the_dir)
+        # the checkpoints inside the job are aligned to the clusters as well
+        chunkEvents = int(opts.chunkevents) if int(opts.chunkevents)>0 else maxEvents
+        chunkStarts = split_range(firstEntries[jobIndex],firstEntries[jobIndex+1],chunkEvents,clusters,nEvents)
+
+        ajob=Job(opts.jobname, firstEvent, maxEvents, opts.sample, opts.pu, opts.ageing, opts.rocrows, opts.roccols, opts.bpixthr, opts.eventcontent, opts.prune, chunkStarts, opts.nodecache, the_dir)
         ajob.createThePBSFile()
 
-        dqmoutput=ajob.job_basename+".root"
-        dqmoutput.replace("digitodqm_","digitodqm_inDQM")        
         # this is needed for the script doing the harvesting
-        DQMFileList+="file:"+os.path.join(ajob.out_dir,dqmoutput)+","
+        ManifestList+=ajob.manifest+" "
+        for first,last in zip(chunkStarts[:-1],chunkStarts[1:]):
+            ChunkList+=str(first)+":"+str(last-first)+" "
 
         out_dir = ajob.out_dir # save for later usage
         
+        # on resubmission only the jobs with missing chunks are sent again
         if opts.submit:
-            ajob.submit()
+            if ajob.isComplete():
+                print ajob.job_basename, "already complete"
+            else:
+                ajob.submit()
             del ajob
 
-        remainder -= eventsPerJob
-        firstEvent += eventsPerJob
         jobIndex+=1
   
     #############################################
@@ -267,7 +454,11 @@ def main():
     fout.write("cmssw_ver="+CMSSW_VER+" \n")
     fout.write("cd "+os.path.join(HOME,"SLHCSimPhase2","${cmssw_ver}","src")+"\n")
     fout.write("eval `scram r -sh`\n")
-    fout.write("DQMFileList="+DQMFileList[:-1]+" \n")
+    fout.write("# the DQM files of all the chunks done so far (partial jobs included), each chunk once \n")
+    fout.write("chunks=\""+ChunkList.strip()+"\" \n")
+    fout.write("DQMFileList=$(cat "+ManifestList+" 2>/dev/null | sort -u -k1,1 | awk -v chunks=\"${chunks}\" 'BEGIN {n=split(chunks,c,\" \"); for (i=1;i<=n;i++) want[c[i]]=1} ($2\":\"$3) in want {printf \"file:"+out_dir+"/%s,\", $4}') \n")
+    fout.write("DQMFileList=${DQMFileList%,} \n")
+    fout.write("echo \"harvesting $(echo ${DQMFileList} | tr ',' '\\n' | wc -l) DQM files\" \n")
     fout.write("cmsDriver.py step4  --geometry Extended2017 --customise SLHCUpgradeSimulations/Configuration/phase1TkCustoms.customise --conditions auto:upgrade2017 --mc  -s HARVESTING:validationHarvesting+dqmHarvesting --filein $DQMFileList --fileout file:step4.root  > step4_FourMuPt1_200_UPG2017+FourMuPt1_200_UPG2017+DIGIUP17+RECOUP17+HARVESTUP17.log \n")
     fout.close()
 
@@ -0,0 +1,85 @@
+#!/bin/sh
+#
+# Node-local cache of the input files shared by the jobs running on the same node
+# (the MinBias pileup file of a scan, which the mixing module reads across its whole
+# length; the GEN-SIM file is read directly, since each job only reads its own range).
+#
+# usage: NodeLocalInputCache.sh acquire <file> <owner>   prints the name of the file to be read
+#        NodeLocalInputCache.sh release <file> <owner>
+#
+# The first job asking for a file copies it once into $NODE_CACHE_DIR (a node-local
+# disk by default: the co-located jobs still share the same pages of the page cache,
+# which, unlike a tmpfs, are not pinned in RAM nor charged to the memory limit of the
+# job doing the copy); the others wait for the copy under the lock and then read the
+# cached file. Each job registers
+# itself as an owner (normally the pid of the job script); the cached file is evicted
+# when the last owner releases it. Owners whose process is gone are dropped, so a
+# killed job does not pin a file forever. If the file cannot be cached (not enough
+# space, copy failure) the original name is returned.
+
+action=$1
+input=$2
+owner=${3:-$PPID}
+
+if [ -z "${action}" ] || [ -z "${input}" ]; then
+    echo "usage: $0 acquire|release <file> [<owner>]" 1>&2
+    exit 1
+fi
+
+# not the PBS $TMPDIR, which is private to each job
+CACHE_DIR=${NODE_CACHE_DIR:-/tmp/${USER}/SLHCSimPhase2_cache}
+# keep this free in the cache area, in MB
+CACHE_RESERVE_MB=${NODE_CACHE_RESERVE_MB:-1024}
+
+path=$(echo ${input} | sed 's%^file:%%')
+key=$(echo ${path} | md5sum | cut -c1-16)
+entry=${CACHE_DIR}/${key}
+cached=${entry}/$(basename ${path})
+
+mkdir -p ${entry}/owners || { echo ${input}; exit 0; }
+
+# drop the owners whose process is gone
+clean_owners() {
+    for o in $(ls ${entry}/owners); do
+        kill -0 ${o} 2>/dev/null || rm -f ${entry}/owners/${o}
+    done
+}
+
+(
+    flock -x 9
+    clean_owners
+    case ${action} in
+        acquire)
+            if [ ! -f ${cached} ]; then
+                size_mb=$(( $(stat -c %s ${path}) / 1048576 + 1 ))
+                free_mb=$(df -P -m ${CACHE_DIR} | awk 'NR==2 {print $4}')
+                # a tmpfs cache lives in memory: the copy must fit in the available memory as well
+                if [ "$(stat -f -c %T ${CACHE_DIR})" = "tmpfs" ]; then
+                    mem_mb=$(awk '/^MemAvailable:/ {print int($2/1024)}' /proc/meminfo)
+                    if [ -n "${mem_mb}" ] && [ ${mem_mb} -lt ${free_mb} ]; then free_mb=${mem_mb}; fi
+                fi
+                if [ $((free_mb - size_mb)) -gt ${CACHE_RESERVE_MB} ] && cp ${path} ${cached}.tmp && mv ${cached}.tmp ${cached}; then
+                    echo "cached ${path} in ${cached}" 1>&2
+                else
+                    rm -f ${cached}.tmp
+                    echo "cannot cache ${path}, reading it directly" 1>&2
+                    echo ${input}
+                    exit 0
+                fi
+            fi
+            touch ${entry}/owners/${owner}
+            echo "file:${cached}"
+            ;;
+        release)
+            rm -f ${entry}/owners/${owner}
+            if [ -z "$(ls ${entry}/owners)" ]; then
+                echo "evicting ${cached}" 1>&2
+                rm -f ${cached}
+            fi
+            ;;
+        *)
+            echo "unknown action ${action}" 1>&2
+            exit 1
+            ;;
+    esac
+) 9>${entry}/lock
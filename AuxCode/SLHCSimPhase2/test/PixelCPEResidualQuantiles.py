@@ -0,0 +1,71 @@
+#!/usr/bin/env python
+
+import os,sys
+import re
+from array import array
+# generic  python modules
+from optparse import OptionParser
+
+import ROOT
+
+# residual histograms written by PixelCPEResidualSummary, one per cluster size
+residualPattern = re.compile("^(resX|resY)_size([0-9]+)(plus)?$")
+titles = {'resX':'x residual','resY':'y residual'}
+
+###########################################################################
+def summarize(inDir,outDir):
+###########################################################################
+    """median and 68% half-width vs cluster size of the residuals of a directory"""
+    residuals = {}
+    for key in inDir.GetListOfKeys():
+        match = residualPattern.match(key.GetName())
+        if match is None: continue
+        residuals.setdefault(match.group(1),[]).append((int(match.group(2)),key.ReadObj()))
+
+    probs = array('d',[0.16,0.50,0.84])
+    quantiles = array('d',[0.,0.,0.])
+    for name,histos in sorted(residuals.items()):
+        histos.sort()
+        outDir.cd()
+        median = ROOT.TH1F(name+"_median",titles[name]+" median;cluster size;median [#mum]",len(histos),0.5,len(histos)+0.5)
+        width  = ROOT.TH1F(name+"_width68",titles[name]+" 68% half-width;cluster size;#sigma_{68} [#mum]",len(histos),0.5,len(histos)+0.5)
+        for i,(size,h) in enumerate(histos):
+            if h.GetEntries()<2: continue
+            h.GetQuantiles(3,quantiles,probs)
+            median.SetBinContent(i+1,quantiles[1])
+            width.SetBinContent(i+1,0.5*(quantiles[2]-quantiles[0]))
+        median.Write()
+        width.Write()
+
+###########################################################################
+def walk(inDir,outDir):
+###########################################################################
+    summarize(inDir,outDir)
+    for key in inDir.GetListOfKeys():
+        if not key.GetClassName().startswith("TDirectory"): continue
+        walk(inDir.Get(key.GetName()),outDir.mkdir(key.GetName()))
+
+#################
+def main():
+### MAIN LOOP ###
+
+    desc="""Computes the median and 68% half-width vs cluster size of the pixel residuals
+written by PixelCPEResidualSummary. Run it on the hadd-merged output of the jobs: the
+quantiles are written to a separate file, which is not meant to be merged."""
+    parser = OptionParser(description=desc,version='%prog version 0.1')
+    parser.add_option('-i','--input',help='(merged) PixelCPEResidualSummary file', dest='input', action='store', default='PixelCPEResidualSummary.root')
+    parser.add_option('-o','--output',help='output file of the quantiles', dest='output', action='store', default='PixelCPEResidualQuantiles.root')
+    (opts, args) = parser.parse_args()
+
+    fin = ROOT.TFile.Open(opts.input)
+    if not fin or fin.IsZombie():
+        print "cannot open", opts.input
+        sys.exit(1)
+    fout = ROOT.TFile(opts.output,"RECREATE")
+    walk(fin,fout)
+    fout.Close()
+    fin.Close()
+    print "quantiles written to", opts.output
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,115 @@
+#!/usr/bin/env python
+
+import os,sys
+import glob
+import time
+# generic  python modules
+from optparse import OptionParser
+
+# fields of the heartbeat records written by the JobHeartbeat service
+jobFields = ['time','start','status','events','expected','rate','rssMB','module']
+
+###########################################################################
+def read_heartbeat(filename):
+###########################################################################
+    """parses the key=value record of a job"""
+    record = {}
+    try:
+        line = open(filename).readline()
+    except IOError:
+        return None
+    for field in line.split():
+        if "=" in field:
+            key,value = field.split("=",1)
+            record[key] = value
+    if not 'time' in record:
+        return None
+    record['name'] = os.path.basename(filename).replace(".hb","")
+    for key in ['time','start','events','expected']:
+        record[key] = int(record.get(key,"-1"))
+    for key in ['rate','rssMB']:
+        record[key] = float(record.get(key,"0"))
+    return record
+
+###########################################################################
+def format_duration(seconds):
+###########################################################################
+    if seconds is None:
+        return "n/a"
+    seconds = int(seconds)
+    return "%dh%02dm" % (seconds/3600,(seconds%3600)/60)
+
+#################
+def main():
+### MAIN LOOP ###
+
+    desc="""Summarizes the heartbeat records (*.hb) of the jobs of a campaign (the submitter
+writes a queued record for each job, so the jobs not started yet are counted as well)."""
+    parser = OptionParser(description=desc,version='%prog version 0.1')
+    parser.add_option('-d','--dir',help='directory of the heartbeat records', dest='dir', action='store', default='.')
+    parser.add_option('-s','--stale',help='seconds without heartbeat after which a running job is stale', dest='stale', action='store', default='600')
+    parser.add_option('-n','--slowest',help='number of slowest jobs to show', dest='slowest', action='store', default='10')
+    (opts, args) = parser.parse_args()
+
+    now = time.time()
+    records = []
+    for filename in sorted(glob.glob(os.path.join(opts.dir,"*.hb"))):
+        record = read_heartbeat(filename)
+        if record is None:
+            print "cannot read", filename
+            continue
+        # a running job that stopped writing is most probably dead
+        if record['status']=="running" and now-record['time']>int(opts.stale):
+            record['status'] = "stale"
+        # projected completion from the current rate
+        record['eta'] = None
+        if record['status'] in ["running","paused"] and record['rate']>0 and record['expected']>0:
+            record['eta'] = max(0,record['expected']-record['events'])/record['rate']
+        records.append(record)
+
+    if len(records)==0:
+        print "no heartbeat records in", opts.dir
+        return
+
+    # campaign summary
+    done     = sum([r['events'] for r in records])
+    expected = sum([r['expected'] for r in records if r['expected']>0])
+    byStatus = {}
+    for r in records:
+        byStatus[r['status']] = byStatus.get(r['status'],0)+1
+    etas = [r['eta'] for r in records if r['eta'] is not None]
+    print "jobs:", len(records), " ".join(["%s=%d" % (s,n) for s,n in sorted(byStatus.items())])
+    print "events: %d / %d (%.1f%%)" % (done,expected,100.*done/expected if expected>0 else 0.)
+    print "projected completion of the running jobs:", format_duration(max(etas) if len(etas)>0 else None)
+    print "max RSS: %.0f MB" % max([r['rssMB'] for r in records])
+
+    # parameters of the jobs (everything not being a job field: PUScenario, AgeingScenario, BPixThr)
+    parameters = sorted(set([k for r in records for k in r.keys() if k not in jobFields+['name','eta']]))
+
+    # averages per parameter point
+    points = {}
+    for r in records:
+        point = tuple([r.get(p,"-") for p in parameters])
+        points.setdefault(point,[]).append(r)
+    print
+    print "%-40s %5s %10s %10s %10s" % (",".join(parameters),"jobs","ev/s","RSS [MB]","ETA")
+    for point in sorted(points.keys()):
+        rs = points[point]
+        rates = [r['rate'] for r in rs if r['rate']>0]
+        etas = [r['eta'] for r in rs if r['eta'] is not None]
+        print "%-40s %5d %10.3f %10.0f %10s" % (",".join(point),len(rs),
+                                                sum(rates)/len(rates) if len(rates)>0 else 0.,
+                                                max([r['rssMB'] for r in rs]),
+                                                format_duration(max(etas) if len(etas)>0 else None))
+
+    # slowest jobs still to finish
+    print
+    print "slowest jobs:"
+    active = [r for r in records if r['status'] not in ["done","queued"]]
+    active.sort(key=lambda r: r['rate'])
+    for r in active[:int(opts.slowest)]:
+        print "%-80s %-8s %6d/%-6d %8.3f ev/s %7.0f MB %10s  in %s" % (r['name'],r['status'],r['events'],r['expected'],
+                                                                      r['rate'],r['rssMB'],format_duration(r['eta']),r['module'])
+
+if __name__ == "__main__":
+    main()
@@ -4,6 +4,29 @@
 # Source: /local/reps/CMSSW/CMSSW/Configuration/Applications/python/ConfigBuilder.py,v 
 # with command line options: Configuration/GenProduction/python/FourteenTeV/TenMuE_0_200_cff.py --no_exec -s GEN,SIM,DIGI,L1,DIGI2RAW,RAW2DIGI,L1Reco,RECO --conditions auto:upgrade2017 --eventcontent FEVTDEBUG --beamspot Gauss --geometry Extended2017 --relval 10000,100 --datatier GEN-SIM-RECO -n 500 --customise SLHCUpgradeSimulations/Configuration/postLS1Customs.customisePostLS1,SLHCUpgradeSimulations/Configuration/phase1TkCustoms.customise --fileout file:TenMuE_0_200_cff_py_GEN_SIM_RECO.root
 import FWCore.ParameterSet.Config as cms
+import FWCore.ParameterSet.VarParsing as VarParsing
+
+options = VarParsing.VarParsing()
+
+options.register('PerHitPrescale',
+                 0,
+                 VarParsing.VarParsing.multiplicity.singleton,
+                 VarParsing.VarParsing.varType.int,
+                 "Write one pixel hit every PerHitPrescale to the per-hit ntuple of the summary (0 = no ntuple, default)")
+
+options.register('StdHitNtuple',
+                 0,
+                 VarParsing.VarParsing.multiplicity.singleton,
+                 VarParsing.VarParsing.varType.int,
+                 "Also run the full per-hit StdHitNtuplizer (0 is default)")
+
+options.register('WriteFEVTDEBUG',
+                 0,
+                 VarParsing.VarParsing.multiplicity.singleton,
+                 VarParsing.VarParsing.varType.int,
+                 "Write the FEVTDEBUG event content (0 is default)")
+
+options.parseArguments()
 
 process = cms.Process('RECO')
 
@@ -122,12 +145,26 @@ process.ReadLocalMeasurement = cms.EDAnalyzer("StdHitNtuplizer",
                          'g4SimHitsTrackerHitsPixelEndcapLowTof',
                          'g4SimHitsTrackerHitsPixelEndcapHighTof')
 )
+
+# residual and pull distributions per layer/disk, orientation and cluster size accumulated online
+# (mergeable with hadd), with an optional prescaled per-hit ntuple
+process.load('AuxCode.SLHCSimPhase2.pixelcperesidualsummary_cfi')
+process.pixelcperesidualsummary.PerHitPrescale = cms.uint32(options.PerHitPrescale)
+process.TFileService = cms.Service("TFileService",
+                                   fileName = cms.string("PixelCPEResidualSummary.root")
+                                   )
+
 # since cmsDriver generates a "Schedule" the ntuplizer needs to be defined as "Path"
-process.make_ntuple = cms.Path(process.ReadLocalMeasurement)
+if options.StdHitNtuple:
+    process.make_ntuple = cms.Path(process.pixelcperesidualsummary*process.ReadLocalMeasurement)
+else:
+    process.make_ntuple = cms.Path(process.pixelcperesidualsummary)
 ######################################################################################
 
 # Schedule definition
-process.schedule = cms.Schedule(process.generation_step,process.genfiltersummary_step,process.simulation_step,process.digitisation_step,process.L1simulation_step,process.digi2raw_step,process.raw2digi_step,process.L1Reco_step,process.reconstruction_step,process.make_ntuple,process.endjob_step,process.FEVTDEBUGoutput_step)
+process.schedule = cms.Schedule(process.generation_step,process.genfiltersummary_step,process.simulation_step,process.digitisation_step,process.L1simulation_step,process.digi2raw_step,process.raw2digi_step,process.L1Reco_step,process.reconstruction_step,process.make_ntuple,process.endjob_step)
+if options.WriteFEVTDEBUG:
+    process.schedule.append(process.FEVTDEBUGoutput_step)
 # filter all path with the production filter sequence
 for path in process.paths:
 	getattr(process,path)._seq = process.ProductionFilterSequence * getattr(process,path)._seq 
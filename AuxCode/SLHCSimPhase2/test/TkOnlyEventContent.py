@@ -0,0 +1,38 @@
+import FWCore.ParameterSet.Config as cms
+
+# tracker-only event content for the phase2 DIGI-to-DQM validation jobs
+# (to be used together with TkOnlyValidationCustoms.customise_tkonly)
+TkOnlyEventContent = cms.PSet(
+    outputCommands = cms.untracked.vstring('drop *',
+                                           # generator and simulation truth used by the tracker validation
+                                           'keep *_genParticles_*_*',
+                                           'keep PSimHits_g4SimHits_TrackerHits*_*',
+                                           'keep SimTracks_g4SimHits_*_*',
+                                           'keep SimVertexs_g4SimHits_*_*',
+                                           'keep *_mix_MergedTrackTruth_*',
+                                           'keep PileupSummaryInfos_*_*_*',
+                                           # pixel and strip digis
+                                           'keep *_simSiPixelDigis_*_*',
+                                           'keep *_simSiStripDigis_*_*',
+                                           'keep *_siPixelDigis_*_*',
+                                           'keep *_siStripDigis_*_*',
+                                           # clusters and rechits
+                                           'keep *_siPixelClusters_*_*',
+                                           'keep *_siStripClusters_*_*',
+                                           'keep *_siPixelRecHits_*_*',
+                                           'keep *_siStripMatchedRecHits_*_*',
+                                           # tracks and vertices
+                                           'keep *_generalTracks_*_*',
+                                           'keep *_offlinePrimaryVertices_*_*',
+                                           'keep *_offlineBeamSpot_*_*',
+                                           'keep edmTriggerResults_*_*_*')
+    )
+
+def customise_tkonly_eventcontent(process,
+                                  outputModuleName = "FEVTDEBUGHLToutput"):
+    # slim the content of the output module down to the tracker products
+    # (the output settings of the step config are left as they are)
+    output = getattr(process,outputModuleName)
+    output.outputCommands = TkOnlyEventContent.outputCommands
+    output.dataset.dataTier = cms.untracked.string('GEN-SIM-RECO')
+    return(process)
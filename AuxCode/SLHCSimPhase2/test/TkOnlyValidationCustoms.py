@@ -45,6 +45,146 @@ def customise_tkonly(process):
     process.trackValidator.label = cms.VInputTag(cms.InputTag("generalTracks"))   
     return(process)
 
+# paths whose producers are only kept if something downstream reads them
+prunablePaths = ['L1simulation_step',
+                 'digi2raw_step',
+                 'raw2digi_step',
+                 'L1Reco_step',
+                 'reconstruction_step',
+                 'prevalidation_step',
+                 'dqmoffline_step']
+
+class _ModuleCollector(object):
+    """collects the modules scheduled on a path/sequence"""
+    def __init__(self):
+        self.modules = []
+    def enter(self,visitee):
+        if isinstance(visitee,(cms.EDProducer,cms.EDFilter,cms.EDAnalyzer)):
+            self.modules.append(visitee)
+    def leave(self,visitee):
+        pass
+
+def _scheduledModules(sequence):
+    collector = _ModuleCollector()
+    sequence.visit(collector)
+    return collector.modules
+
+def _inputLabels(pset,labels):
+    # module labels of all the InputTags (and plain strings, to be safe) found in a PSet
+    for name,par in pset.parameters_().iteritems():
+        if isinstance(par,cms.InputTag):
+            labels.add(par.getModuleLabel())
+        elif isinstance(par,cms.VInputTag):
+            for tag in par:
+                if isinstance(tag,str):
+                    labels.add(tag.split(':')[0])
+                else:
+                    labels.add(tag.getModuleLabel())
+        elif isinstance(par,cms.string):
+            labels.add(par.value())
+        elif isinstance(par,cms.vstring):
+            labels.update(par.value())
+        elif isinstance(par,cms.PSet):
+            _inputLabels(par,labels)
+        elif isinstance(par,cms.VPSet):
+            for p in par:
+                _inputLabels(p,labels)
+    return labels
+
+def _keptLabels(output):
+    # module labels explicitly kept by an output module ("keep type_label_instance_process")
+    labels = set()
+    if hasattr(output,"outputCommands"):
+        for command in output.outputCommands:
+            fields = command.split()
+            if len(fields)!=2 or fields[0]!="keep": continue
+            branch = fields[1].split('_')
+            if len(branch)==4 and '*' not in branch[1] and '?' not in branch[1]:
+                labels.add(branch[1])
+    return labels
+
+def _walkBack(process,aliases,seeds):
+    # the seeds and all the producers/filters they read, directly or not
+    needed = set(seeds)
+    toVisit = list(needed)
+    while len(toVisit)>0:
+        label = toVisit.pop()
+        inputs = set()
+        if label in aliases:
+            inputs.update(aliases[label])
+        elif hasattr(process,label) and hasattr(getattr(process,label),'parameters_'):
+            _inputLabels(getattr(process,label),inputs)
+        for input in inputs:
+            if input not in needed and (input in aliases or input in process.producers_() or input in process.filters_()):
+                needed.add(input)
+                toVisit.append(input)
+    return needed
+
+def customise_tkonly_prune(process, keepModules = []):
+    """
+    starting from the tracker validation/DQM consumers and the output modules, walks
+    back the product dependencies and removes from the prunable paths every producer
+    whose products are not read by anybody.
+    The DQM sources are tracker sources when everything they read is a tracker product
+    (a product kept by TkOnlyEventContent, or one of its inputs); the other ones are
+    removed from DQMOffline, so that their producers are removed as well.
+    Modules reading products by type (and not through their configuration) must be
+    listed in keepModules.
+    The output must be the TkOnly content, since wildcard keep statements are not followed.
+    """
+    from TkOnlyEventContent import TkOnlyEventContent
+
+    # EDAliases point to the modules actually producing the products
+    aliases = {}
+    if hasattr(process,'aliases_'):
+        for label,alias in process.aliases_().iteritems():
+            aliases[label] = set(alias.parameterNames_())
+
+    def isModule(label):
+        return label in aliases or label in process.producers_() or label in process.filters_()
+
+    # remove the DQM sources reading non-tracker products
+    trackerLabels = _walkBack(process,aliases,_keptLabels(TkOnlyEventContent))
+    removed = set()
+    if hasattr(process,'dqmoffline_step'):
+        for module in _scheduledModules(process.dqmoffline_step):
+            if not isinstance(module,(cms.EDAnalyzer,cms.EDFilter)): continue
+            inputs = set([label for label in _inputLabels(module,set()) if isModule(label)])
+            if module.label_() in keepModules or inputs.issubset(trackerLabels): continue
+            process.dqmoffline_step.remove(module)
+            removed.add(module.label_())
+
+    # the consumers: the analyzers, the filters (kept below, so their inputs are
+    # needed too), everything on the other paths and the output modules
+    seeds = set(keepModules)
+    allpaths = dict(process.paths_())
+    allpaths.update(process.endpaths_())
+    for label,path in allpaths.iteritems():
+        for module in _scheduledModules(path):
+            if label not in prunablePaths or isinstance(module,(cms.EDAnalyzer,cms.EDFilter)):
+                seeds.add(module.label_())
+    for label,output in process.outputModules_().iteritems():
+        seeds.update(_keptLabels(output))
+
+    # walk back the dependencies
+    needed = _walkBack(process,aliases,seeds)
+
+    # remove the producers nobody reads (filters are kept since they change the path result)
+    for name in prunablePaths:
+        if not hasattr(process,name): continue
+        path = getattr(process,name)
+        for module in _scheduledModules(path):
+            if isinstance(module,cms.EDProducer) and module.label_() not in needed:
+                path.remove(module)
+                removed.add(module.label_())
+    print "customise_tkonly_prune: removed", len(removed), "modules from", prunablePaths
+    for label in sorted(removed):
+        print "   ", label
+
+    # the TimeReport at the end of the job gives the CPU time per module, to compare with the full schedule
+    process.options.wantSummary = cms.untracked.bool(True)
+    return(process)
+
 
 
 
@@ -14,12 +14,24 @@ options.register('InputFileName',
                  VarParsing.VarParsing.varType.string,         # string, int, or float
                  "name of the input file ")
 
+options.register('PileupFileName',
+                 "file:/lustre/cms/store/user/musich/SLHCSimPhase2/Samples/MinBias/step1_MinBias_TuneZ2star_14TeV_pythia6_15k_evts.root", # default value
+                 VarParsing.VarParsing.multiplicity.singleton, # singleton or list
+                 VarParsing.VarParsing.varType.string,         # string, int, or float
+                 "name of the MinBias file used for the pileup")
+
 options.register('firstEvent',
                  1,
                  VarParsing.VarParsing.multiplicity.singleton,
                  VarParsing.VarParsing.varType.int,
                  "First event to process")
 
+options.register('skipEvents',
+                 0,
+                 VarParsing.VarParsing.multiplicity.singleton,
+                 VarParsing.VarParsing.varType.int,
+                 "Number of entries to skip in the input file (0 is default)")
+
 options.register('maxEvents',
                  -1,
                  VarParsing.VarParsing.multiplicity.singleton,
@@ -50,6 +62,36 @@ options.register('AgeingScenario',
                  VarParsing.VarParsing.varType.string,         # string, int, or float
                  "Ageing scenario (NoAgeing is default)")
 
+options.register('EventContent',
+                 "FEVTDEBUGHLT", # default value
+                 VarParsing.VarParsing.multiplicity.singleton, # singleton or list
+                 VarParsing.VarParsing.varType.string,         # string, int, or float
+                 "Event content of the output file (FEVTDEBUGHLT is default, TkOnly for tracker products only)")
+
+options.register('PruneSchedule',
+                 0,
+                 VarParsing.VarParsing.multiplicity.singleton,
+                 VarParsing.VarParsing.varType.int,
+                 "Remove the producers not needed by the tracker validation (0 is default)")
+
+options.register('HeartbeatFile',
+                 "", # default value
+                 VarParsing.VarParsing.multiplicity.singleton, # singleton or list
+                 VarParsing.VarParsing.varType.string,         # string, int, or float
+                 "file where the job writes its periodic heartbeat record (none by default)")
+
+options.register('HeartbeatEventsDone',
+                 0,
+                 VarParsing.VarParsing.multiplicity.singleton,
+                 VarParsing.VarParsing.varType.int,
+                 "events of the job range already done by previous chunks (0 is default)")
+
+options.register('HeartbeatEventsExpected',
+                 -1,
+                 VarParsing.VarParsing.multiplicity.singleton,
+                 VarParsing.VarParsing.varType.int,
+                 "events of the whole job range (-1 = maxEvents, default)")
+
 options.parseArguments()
 
 process = cms.Process('RECO')
@@ -63,7 +105,7 @@ process.load('Configuration.EventContent.EventContent_cff')
 if options.PUScenario!="NoPU":
 
     process.load('SimGeneral.MixingModule.mix_E8TeV_AVE_16_BX_25ns_cfi')
-    process.mix.input.fileNames = cms.untracked.vstring(['file:/lustre/cms/store/user/musich/SLHCSimPhase2/Samples/MinBias/step1_MinBias_TuneZ2star_14TeV_pythia6_15k_evts.root'])
+    process.mix.input.fileNames = cms.untracked.vstring([options.PileupFileName])
     process.mix.bunchspace = cms.int32(25)
     process.mix.minBunch = cms.int32(-12)
     process.mix.maxBunch = cms.int32(3)
@@ -121,7 +163,8 @@ process.maxEvents = cms.untracked.PSet(
 process.source = cms.Source("PoolSource",
                             secondaryFileNames = cms.untracked.vstring(),
                             fileNames = cms.untracked.vstring(options.InputFileName),
-                            firstEvent = cms.untracked.uint32(options.firstEvent)
+                            firstEvent = cms.untracked.uint32(options.firstEvent),
+                            skipEvents = cms.untracked.uint32(options.skipEvents)
                             )
 
 process.options = cms.untracked.PSet(
@@ -166,6 +209,20 @@ process.DQMoutput = cms.OutputModule("PoolOutputModule",
 
 # Additional output definition
 
+# Additional services
+if options.HeartbeatFile!="":
+    # periodic record of events done, rate, RSS and current module, read by SummarizeHeartbeats.py
+    process.JobHeartbeat = cms.Service("JobHeartbeat",
+                                       HeartbeatFile = cms.untracked.string(options.HeartbeatFile),
+                                       Interval = cms.untracked.int32(60),
+                                       ExpectedEvents = cms.untracked.int32(options.HeartbeatEventsExpected if options.HeartbeatEventsExpected>=0 else options.maxEvents),
+                                       EventsOffset = cms.untracked.uint32(options.HeartbeatEventsDone),
+                                       Parameters = cms.untracked.PSet(PUScenario = cms.untracked.string(options.PUScenario),
+                                                                       AgeingScenario = cms.untracked.string(options.AgeingScenario),
+                                                                       BPixThr = cms.untracked.string(str(options.BPixThr))
+                                                                       )
+                                       )
+
 # Other statements
 from Configuration.AlCa.GlobalTag import GlobalTag
 process.GlobalTag = GlobalTag(process.GlobalTag, 'auto:upgrade2017', '')
@@ -249,6 +306,19 @@ process = customise(process)
 from TkOnlyValidationCustoms import customise_tkonly
 process = customise_tkonly(process)
 
+# slim output content (keeping only tracker products)
+if options.EventContent=="TkOnly":
+    from TkOnlyEventContent import customise_tkonly_eventcontent
+    process = customise_tkonly_eventcontent(process)
+
+# drop the producers whose only consumers were the removed validation/DQM modules
+# (only with the TkOnly content, since wildcard keep statements are not followed)
+if options.PruneSchedule:
+    if options.EventContent!="TkOnly":
+        raise RuntimeError("PruneSchedule=1 needs EventContent=TkOnly: the producers of the "+options.EventContent+" content would be dropped")
+    from TkOnlyValidationCustoms import customise_tkonly_prune
+    process = customise_tkonly_prune(process)
+
 # Uncomment next two lines to change pixel DIGI threshold
 process.mix.digitizers.pixel.ThresholdInElectrons_BPix = cms.double(options.BPixThr)
 process.mix.digitizers.pixel.ThresholdInElectrons_BPix_L1 = cms.double(options.BPixThr)